@@ -1,20 +1,32 @@
 ﻿#include "AgoraRtcEngine.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include<QMessageBox>
 #include "DlgSettings.h"  
 #include <QCoreApplication>
+#include <QDir>
 #include <VideoWidget.h>
+#include "CameraFormats.h"
 #include <QMutexLocker>
 //#include "agora_log.h"
 //#include <mutex>
 //#include <thread>
 
+//document camera capture: pages stay readable at 1080p, and they change too
+//slowly to need more frames; the capture format closest to it is chosen
+#define DOCUMENT_CAMERA_WIDTH 1920
+#define DOCUMENT_CAMERA_HEIGHT 1080
+#define DOCUMENT_CAMERA_FPS 15
+//slides and text, sharpness matters more than motion; the low rate keeps the
+//encoder load down while the cameras are sent too
+#define SCREEN_SHARE_FPS 15
+
+//engine level events, channel events arrive on AgoraRtcEngineEventEx
 class AgoraRtcEngineEvent : public agora::rtc::IRtcEngineEventHandler
 {
 	AgoraRtcEngine* m_engine;
 public:
-	bool bEx = false;
 	AgoraRtcEngineEvent(AgoraRtcEngine* engine)
 		:m_engine(engine)
 	{}
@@ -22,64 +34,99 @@ public:
 	{
 		//emit m_engine.videoStopped();
 	}
-	virtual void onJoinChannelSuccess(const char* channel, agora::rtc::uid_t uid, int elapsed) override
-	{
-		emit m_engine->joinedChannelSuccess(channel, uid, elapsed);
-	}
-	
-	virtual void onUserJoined(agora::rtc::uid_t uid, int elapsed) override
-	{
-		if (uid == setting.userInfo.uid || uid == setting.userInfo2.uid)
-			return;
-		unsigned int userId = (unsigned int)uid;
-		//if (!bEx)
-			emit m_engine->userJoined(userId, elapsed);
-	}
-	virtual void onUserOffline(agora::rtc::uid_t uid, agora::rtc::USER_OFFLINE_REASON_TYPE reason) override
-	{
-		if (!bEx)
-			emit m_engine->userOffline(uid, reason);
-	}
 	virtual void onFirstLocalVideoFrame(int width, int height, int elapsed) override
 	{
 		//emit m_engine.firstLocalVideoFrame(width, height, elapsed);
 	}
-	virtual void onFirstRemoteVideoDecoded(agora::rtc::uid_t uid, int width, int height, int elapsed) override
-	{
-		//emit m_engine.firstRemoteVideoDecoded(uid, width, height, elapsed);
-	}
-	virtual void onFirstRemoteVideoFrame(agora::rtc::uid_t uid, int width, int height, int elapsed) override
-	{
-		//emit m_engine.firstRemoteVideoFrameDrawn(uid, width, height, elapsed);
-	}
 
+	//device test volume
 	virtual void onAudioVolumeIndication(const agora::rtc::AudioVolumeInfo* speakers, unsigned int speakerNumber, int totalVolume)
 	{
 		if (m_engine)
 			emit m_engine->volumeIndication(totalVolume, speakerNumber, totalVolume);
 	}
 
-	virtual void onStreamMessage(agora::rtc::uid_t userId, int streamId, const char* data, size_t length, uint64_t sentTs) override {
-		if (m_engine) {
-			emit m_engine->streamMessage(userId, QString::fromStdString(data));
-		}
+	virtual void onAudioDeviceStateChanged(const char* deviceId, int deviceType, int deviceState) override
+	{
+		if (m_engine)
+			m_engine->RefreshDevices(deviceType == agora::rtc::AUDIO_PLAYOUT_DEVICE ? DEVICE_SPEAKER : DEVICE_MIC);
 	}
 
-	virtual void onLeaveChannel(const agora::rtc::RtcStats& stats) {
-		if (!bEx)
-			emit m_engine->leaveChannelSignal();
+	virtual void onVideoDeviceStateChanged(const char* deviceId, int deviceType, int deviceState) override
+	{
+		if (m_engine)
+			m_engine->RefreshDevices(DEVICE_CAMERA);
 	}
 };
 
+//events of one RtcConnection, each of them is tagged with connection.localUid
 class AgoraRtcEngineEventEx : public agora::rtc::IRtcEngineEventHandlerEx
 {
 	AgoraRtcEngine* m_engine;
 public:
-	bool bEx = false;
+	AgoraRtcEngineEventEx(AgoraRtcEngine* engine)
+		:m_engine(engine)
+	{}
 	virtual void onJoinChannelSuccess(const agora::rtc::RtcConnection& connection, int elapsed) override
 	{
 		emit m_engine->joinedChannelSuccess(connection.channelId, connection.localUid, elapsed);
 	}
+
+	virtual void onUserJoined(const agora::rtc::RtcConnection& connection, agora::rtc::uid_t remoteUid, int elapsed) override
+	{
+		//remote users are seen on every connection, report them once
+		if (m_engine->subscriptions_.OnUserJoined(connection.localUid, remoteUid))
+			emit m_engine->userJoined((unsigned int)remoteUid, elapsed);
+	}
+
+	virtual void onUserOffline(const agora::rtc::RtcConnection& connection, agora::rtc::uid_t remoteUid, agora::rtc::USER_OFFLINE_REASON_TYPE reason) override
+	{
+		m_engine->ClearRemoteVideoStats(connection, remoteUid);
+		if (m_engine->subscriptions_.OnUserOffline(connection.localUid, remoteUid))
+			emit m_engine->userOffline(remoteUid, reason);
+	}
+
+	virtual void onAudioVolumeIndication(const agora::rtc::RtcConnection& connection, const agora::rtc::AudioVolumeInfo* speakers, unsigned int speakerNumber, int totalVolume) override
+	{
+		//only video source 1 publishes the microphone
+		if (connection.localUid == setting.userInfo.uid)
+			emit m_engine->volumeIndication(totalVolume, speakerNumber, totalVolume);
+	}
+
+	virtual void onStreamMessage(const agora::rtc::RtcConnection& connection, agora::rtc::uid_t remoteUid, int streamId, const char* data, size_t length, uint64_t sentTs) override
+	{
+		if (m_engine->subscriptions_.IsOwner(connection.localUid))
+			emit m_engine->streamMessage(remoteUid, QString::fromUtf8(data, (int)length));
+	}
+
+	virtual void onRtcStats(const agora::rtc::RtcConnection& connection, const agora::rtc::RtcStats& stats) override
+	{
+		m_engine->UpdateRtcStats(connection, stats);
+	}
+
+	virtual void onLocalVideoStats(const agora::rtc::RtcConnection& connection, const agora::rtc::LocalVideoStats& stats) override
+	{
+		m_engine->UpdateLocalVideoStats(connection, stats);
+	}
+
+	virtual void onRemoteVideoStats(const agora::rtc::RtcConnection& connection, const agora::rtc::RemoteVideoStats& stats) override
+	{
+		m_engine->UpdateRemoteVideoStats(connection, stats);
+	}
+
+	virtual void onNetworkQuality(const agora::rtc::RtcConnection& connection, agora::rtc::uid_t remoteUid, int txQuality, int rxQuality) override
+	{
+		//uid 0 is the local user of this connection
+		if (remoteUid == 0)
+			m_engine->UpdateNetworkQuality(connection, txQuality, rxQuality);
+	}
+
+	virtual void onLeaveChannel(const agora::rtc::RtcConnection& connection, const agora::rtc::RtcStats& stats) override
+	{
+		m_engine->ClearConnectionStats(connection);
+		if (connection.localUid == setting.userInfo.uid || !setting.enabledVideoSource1)
+			emit m_engine->leaveChannelSignal();
+	}
 };
 
 AgoraRtcEngine AgoraRtcEngine::agoraRtcEngine = nullptr;
@@ -87,23 +134,37 @@ agora::rtc::IRtcEngine* AgoraRtcEngine::m_rtcEngine = nullptr;
 agora::rtc::IRtcEngineEx* AgoraRtcEngine::m_rtcEngineEx = nullptr;
 AgoraRtcEngineEvent AgoraRtcEngine::m_eventHandler = nullptr;
 
-AgoraRtcEngineEvent m_eventHandler2 = nullptr;
-
 AgoraRtcEngine::AgoraRtcEngine(QObject *parent)
 	: QObject(parent)
+	, subscriptions_(&videoSources_)
 {
 	InitVideoFrame();
+	for (int kind = 0; kind < VIDEO_SOURCE_COUNT; ++kind)
+		videoSources_.Add((VIDEO_SOURCE_KIND)kind);
+	//next to the application log, written on the snapshot thread
+	snapshotDir_ = QDir::currentPath() + "/log/snapshots";
+	connect(&snapshots_, &SnapshotService::snapshotReady, this, [this](unsigned int uid, QImage image) {
+		image.save(QString("%1/%2.jpg").arg(snapshotDir_).arg(uid), "JPG");
+	}, Qt::DirectConnection);
 }
 
 AgoraRtcEngine::~AgoraRtcEngine()
 {
+	if (initThread_.joinable())
+		initThread_.join();
+	devices_.Stop();
+	snapshots_.Stop();
+	recorder_.Stop();
 	RegisterVideoFrameObserver(false);
 	if (media_player_) {
+		player_.SetPlayer(nullptr);
 		media_player_->registerPlayerSourceObserver(nullptr);
 		m_rtcEngine->destroyMediaPlayer(media_player_);
 		media_player_ = nullptr;
 	}
-	m_rtcEngine->release();
+	//never created when only a capture was replayed
+	if (m_rtcEngine)
+		m_rtcEngine->release();
 }
 
 void AgoraRtcEngine::InitVideoFrame()
@@ -136,7 +197,6 @@ AgoraRtcEngine* AgoraRtcEngine::GetAgoraRtcEngine()
 int AgoraRtcEngine::Init()
 {
 	m_eventHandler = AgoraRtcEngineEvent(&agoraRtcEngine);
-	m_eventHandler2 = AgoraRtcEngineEvent(&agoraRtcEngine);
 	agora::rtc::RtcEngineContext context;
 	context.appId = APP_ID;
 	context.eventHandler = &m_eventHandler;
@@ -147,13 +207,56 @@ int AgoraRtcEngine::Init()
 	}
 	
 	m_rtcEngineEx = (agora::rtc::IRtcEngineEx*)m_rtcEngine;
+	subscriptions_.SetEngine(m_rtcEngineEx);
 
 	media_player_ = m_rtcEngine->createMediaPlayer();
 	media_player_->registerPlayerSourceObserver(this);
+	player_.SetPlayer(media_player_);
+	videoSources_.Get(VIDEO_SOURCE_MEDIA_PLAYER)->mediaPlayerId = media_player_->getMediaPlayerId();
 	RegisterVideoFrameObserver(true);
+	devices_.SetChangedFunc([this](DEVICE_KIND kind) {
+		emit devicesChanged(kind);
+	});
+	devices_.Start(m_rtcEngine);
+	recorder_.SetFailedFunc([this]() {
+		emit recordingChanged(false, true);
+	});
+	//stats arrive on the sdk thread, the step is applied on the GUI thread
+	encoder_.SetApplyFunc([this](const agora::rtc::VideoEncoderConfiguration& config) {
+		QMetaObject::invokeMethod(this, [this, config]() {
+			ApplyAdaptedEncoderConfiguration(config);
+		}, Qt::QueuedConnection);
+	});
 	return ret;
 }
 
+//the login dialog is interactive while the sdk loads; every path that needs
+//the engine (login, settings) calls WaitInit first
+void AgoraRtcEngine::InitAsync()
+{
+	if (initThread_.joinable() || initDone_)
+		return;
+	initThread_ = std::thread([this]() {
+		QElapsedTimer timer;
+		timer.start();
+		initResult_ = Init();
+		initDone_ = true;
+		qDebug() << "engine init" << timer.elapsed() << "ms, ret" << initResult_;
+		emit engineReady(initResult_);
+	});
+}
+
+int AgoraRtcEngine::WaitInit()
+{
+	if (initThread_.joinable())
+		initThread_.join();
+	else if (!initDone_) {
+		initResult_ = Init();
+		initDone_ = true;
+	}
+	return initResult_;
+}
+
 agora::rtc::IRtcEngineEx* AgoraRtcEngine::GetEngine()
 {
 	if (m_rtcEngine == NULL) {
@@ -163,44 +266,221 @@ agora::rtc::IRtcEngineEx* AgoraRtcEngine::GetEngine()
 	return m_rtcEngineEx;
 }
 
-void AgoraRtcEngine::VideoSource1SendStreamMessage(QString message)
+bool AgoraRtcEngine::IsVideoSourceJoined(VIDEO_SOURCE_KIND kind)
 {
-	int streadmId = -1;
-	agora::rtc::DataStreamConfig config;
-	int ret = m_rtcEngineEx->createDataStreamEx(&streadmId, config, connection_);
+	VideoSource* source = videoSources_.Get(kind);
+	return source && source->IsJoined();
+}
 
-	std::string str = message.toStdString().data();
+void AgoraRtcEngine::SetVideoSourceJoined(VIDEO_SOURCE_KIND kind, bool b)
+{
+	VideoSource* source = videoSources_.Get(kind);
+	if (source)
+		source->SetJoined(b);
+}
+
+int AgoraRtcEngine::JoinVideoSource(VIDEO_SOURCE_KIND kind, const char* token, const char* channel, agora::rtc::uid_t uid)
+{
+	VideoSource* source = videoSources_.Get(kind);
+	if (!source || !m_rtcEngineEx)
+		return -1;
+	if (!source->EventHandler())
+		source->SetEventHandler(new AgoraRtcEngineEventEx(this));
+	source->SetConnection(channel, uid);
+	source->dataStreamId = -1;
+
+	agora::base::AParameter apm(*m_rtcEngine);
+	apm->setParameters("{\"che.video.quick_adapt_network\" : false}");
+	//owner is known before the first onUserJoined of this connection
+	subscriptions_.OnSourceJoined(source);
+	int ret = m_rtcEngineEx->joinChannelEx(token, source->Connection(), MediaOptions(source), source->EventHandler());
+	if (ret != 0) {
+		subscriptions_.OnSourceLeft(source);
+		return ret;
+	}
+	source->SetJoined(true);
+	if (source->hasEncoderConfig)
+		m_rtcEngineEx->setVideoEncoderConfigurationEx(source->encoderConfig, source->Connection());
+	return ret;
+}
 
-	ret = m_rtcEngineEx->sendStreamMessageEx(streadmId, str.data(), str.length(), connection_);
+int AgoraRtcEngine::LeaveVideoSource(VIDEO_SOURCE_KIND kind)
+{
+	VideoSource* source = videoSources_.Get(kind);
+	if (!source || !m_rtcEngineEx)
+		return -1;
+	int ret = m_rtcEngineEx->leaveChannelEx(source->Connection());
+	if (kind == VIDEO_SOURCE_CAMERA_PRIMARY) {
+		encoder_.Reset();
+		encoderBackend_.End();
+	}
+	source->SetJoined(false);
+	source->dataStreamId = -1;
+	subscriptions_.OnSourceLeft(source);
+	return ret;
 }
 
-void AgoraRtcEngine::VideoSource2SendStreamMessage(QString message)
+int AgoraRtcEngine::UpdateVideoSourceOptions(VIDEO_SOURCE_KIND kind)
 {
-	int streadmId = -1;
-	agora::rtc::DataStreamConfig config;
-	int ret = m_rtcEngineEx->createDataStreamEx(&streadmId, config, connection2_);
+	VideoSource* source = videoSources_.Get(kind);
+	if (!source || !m_rtcEngineEx)
+		return -1;
+	return m_rtcEngineEx->updateChannelMediaOptionsEx(MediaOptions(source), source->Connection());
+}
+
+int AgoraRtcEngine::SetVideoSourceEncoderConfiguration(VIDEO_SOURCE_KIND kind, const agora::rtc::VideoEncoderConfiguration& config)
+{
+	VideoSource* source = videoSources_.Get(kind);
+	if (!source)
+		return -1;
+	source->encoderConfig = config;
+	source->hasEncoderConfig = true;
+	//applied by JoinVideoSource otherwise
+	if (!m_rtcEngineEx || !source->IsJoined())
+		return 0;
+	return m_rtcEngineEx->setVideoEncoderConfigurationEx(config, source->Connection());
+}
+
+int AgoraRtcEngine::SendVideoSourceStreamMessage(VIDEO_SOURCE_KIND kind, QString message)
+{
+	VideoSource* source = videoSources_.Get(kind);
+	if (!source || !m_rtcEngineEx)
+		return -1;
+	if (source->dataStreamId < 0) {
+		agora::rtc::DataStreamConfig config;
+		int ret = m_rtcEngineEx->createDataStreamEx(&source->dataStreamId, config, source->Connection());
+		if (ret != 0) {
+			source->dataStreamId = -1;
+			return ret;
+		}
+	}
+
+	QByteArray data = message.toUtf8();
+	return m_rtcEngineEx->sendStreamMessageEx(source->dataStreamId, data.constData(), data.length(), source->Connection());
+}
+
+int AgoraRtcEngine::StartVideoSourceCapture(VIDEO_SOURCE_KIND kind)
+{
+	int ret = -1;
+	if (kind == VIDEO_SOURCE_CAMERA_PRIMARY) {
+		StartPrimary();
+		ret = 0;
+	}
+	else if (kind == VIDEO_SOURCE_CAMERA_SECONDARY) {
+		agora::rtc::CameraCapturerConfiguration config;
+		QByteArray deviceId = setting.videoSource3Id.toUtf8();
+		strncpy(config.deviceId, deviceId.constData(), agora::rtc::MAX_DEVICE_ID_LENGTH - 1);
+		SelectCameraFormat(setting.videoSource3Id, DOCUMENT_CAMERA_WIDTH, DOCUMENT_CAMERA_HEIGHT,
+			DOCUMENT_CAMERA_FPS, config.format);
+		ret = m_rtcEngine->startSecondaryCameraCapture(config);
+		secondaryCameraId_ = ret == 0 ? setting.videoSource3Id : QString();
+	}
+	else if (kind == VIDEO_SOURCE_SCREEN) {
+		agora::rtc::ScreenCaptureConfiguration config;
+		config.params.frameRate = SCREEN_SHARE_FPS;
+		ret = m_rtcEngine->startPrimaryScreenCapture(config);
+	}
+	return ret;
+}
 
-	std::string str = message.toStdString().data();
+int AgoraRtcEngine::StopVideoSourceCapture(VIDEO_SOURCE_KIND kind)
+{
+	if (kind == VIDEO_SOURCE_CAMERA_SECONDARY) {
+		secondaryCameraId_.clear();
+		return m_rtcEngine->stopSecondaryCameraCapture();
+	}
+	else if (kind == VIDEO_SOURCE_SCREEN)
+		return m_rtcEngine->stopPrimaryScreenCapture();
+	return -1;
+}
 
-	ret = m_rtcEngineEx->sendStreamMessageEx(streadmId, str.data(), str.length(), connection2_);
+bool AgoraRtcEngine::SyncVideoSource(VIDEO_SOURCE_KIND kind, bool enabled, const QString& channel, unsigned int uid)
+{
+	bool joined = IsVideoSourceJoined(kind);
+	if (enabled && joined) {
+		if (kind == VIDEO_SOURCE_CAMERA_SECONDARY && secondaryCameraId_ != setting.videoSource3Id) {
+			StopVideoSourceCapture(kind);
+			StartVideoSourceCapture(kind);
+		}
+		return false;
+	}
+	if (!enabled && !joined)
+		return false;
+	if (!enabled) {
+		LeaveVideoSource(kind);
+		StopVideoSourceCapture(kind);
+		return true;
+	}
+	int ret = StartVideoSourceCapture(kind);
+	if (ret == 0)
+		ret = JoinVideoSource(kind, "", channel.toUtf8(), uid);
+	if (ret != 0) {
+		qDebug() << "video source" << kind << "failed to start" << ret;
+		StopVideoSourceCapture(kind);
+		return false;
+	}
+	return true;
 }
 
-bool AgoraRtcEngine::LocalVideoPreview(HWND hVideoWnd, bool bPreviewOn, agora::media::base::RENDER_MODE_TYPE mode)
+void AgoraRtcEngine::LeaveExtraVideoSources()
+{
+	std::vector<VideoSource*> sources = videoSources_.JoinedSources();
+	for (size_t i = 0; i < sources.size(); ++i) {
+		VIDEO_SOURCE_KIND kind = sources[i]->Kind();
+		if (kind == VIDEO_SOURCE_CAMERA_PRIMARY || kind == VIDEO_SOURCE_MEDIA_PLAYER)
+			continue;
+		LeaveVideoSource(kind);
+		StopVideoSourceCapture(kind);
+	}
+}
+
+agora::rtc::ChannelMediaOptions AgoraRtcEngine::MediaOptions(VideoSource* source) const
+{
+	agora::rtc::ChannelMediaOptions option = source->BuildMediaOptions();
+	subscriptions_.ApplyJoinOptions(option);
+	return option;
+}
+
+void AgoraRtcEngine::VideoSource1SendStreamMessage(QString message)
+{
+	SendVideoSourceStreamMessage(VIDEO_SOURCE_CAMERA_PRIMARY, message);
+}
+
+void AgoraRtcEngine::VideoSource2SendStreamMessage(QString message)
+{
+	SendVideoSourceStreamMessage(VIDEO_SOURCE_MEDIA_PLAYER, message);
+}
+
+bool AgoraRtcEngine::LocalVideoPreview(VideoWidget* widget, bool bPreviewOn, HWND hSdkView, agora::media::base::RENDER_MODE_TYPE mode)
 {
 	int nRet = 0;
 	agora::rtc::VideoCanvas vc;
 	vc.uid = 0;
 	vc.renderMode = mode;
 	if (bPreviewOn) {
-		vc.view = hVideoWnd;
-		m_rtcEngine->setupLocalVideo(vc);
+		{
+			QMutexLocker lock(&mtxPreview_);
+			previewWidget_ = widget;
+		}
+		if (hSdkView) {
+			vc.view = hSdkView;
+			m_rtcEngine->setupLocalVideo(vc);
+			sdkPreviewView_ = true;
+		}
 		nRet = m_rtcEngine->startPreview();
 	}
 	else{
-		if (!joined)
+		{
+			QMutexLocker lock(&mtxPreview_);
+			previewWidget_ = nullptr;
+		}
+		if (!IsJoined())
 			nRet = m_rtcEngine->stopPreview();
-		vc.view = NULL;
-		m_rtcEngine->setupLocalVideo(vc);
+		if (sdkPreviewView_) {
+			vc.view = NULL;
+			m_rtcEngine->setupLocalVideo(vc);
+			sdkPreviewView_ = false;
+		}
 	}
 
 	return nRet == 0 ? true : false;
@@ -209,99 +489,78 @@ bool AgoraRtcEngine::LocalVideoPreview(HWND hVideoWnd, bool bPreviewOn, agora::m
 
 bool AgoraRtcEngine::SetEncoderType(int type)
 {
-//	agora::rtc::AParameter apm(*m_rtcEngine);
-	int ret = 0;//apm->setInt("che.hardware_encoding", type);
-
-	return ret == 0 ? TRUE : FALSE;
+	int active = type;
+	if (!encoderTypeAvailable(type)) {
+		qDebug() << "no" << encoderTypeName(type) << "gpu, encoding in software";
+		active = ENCODER_SOFTWARE;
+	}
+	//the sdk picks the gpu itself, the parameter only turns hardware encoding on
+	agora::base::AParameter apm(*m_rtcEngine);
+	int ret = apm->setInt("che.hardware_encoding", active == ENCODER_SOFTWARE ? 0 : 1);
+	if (ret != 0 && active != ENCODER_SOFTWARE) {
+		qDebug() << encoderTypeName(active) << "encoder refused" << ret << ", encoding in software";
+		active = ENCODER_SOFTWARE;
+		ret = apm->setInt("che.hardware_encoding", 0);
+	}
+	qDebug() << "encoder requested" << encoderTypeName(type) << "active" << encoderTypeName(active);
+	encoderBackend_.Start(type, active);
+	emit encoderChanged(active);
+	return ret == 0 && active == type ? TRUE : FALSE;
 }
 
-void AgoraRtcEngine::UpdateVideoSource2Subscribe(bool subscribe)
-{
-	agora::rtc::ChannelMediaOptions option;
-	option.autoSubscribeAudio = subscribe;
-	option.autoSubscribeVideo = subscribe;
-	option.publishAudioTrack = false;
-	option.publishCameraTrack = false;
-	option.publishMediaPlayerVideoTrack = true;
-	option.publishMediaPlayerAudioTrack = true;
-	option.publishMediaPlayerId = media_player_->getMediaPlayerId();
-	option.clientRoleType = agora::rtc::CLIENT_ROLE_BROADCASTER;
-	option.channelProfile = agora::CHANNEL_PROFILE_LIVE_BROADCASTING;
-	m_rtcEngineEx->updateChannelMediaOptionsEx(option, connection2_);
-}
-
-bool AgoraRtcEngine::VideoSource1JoinChannel(bool enableVideo, const char* token, const char* channel, agora::rtc::uid_t uid, const const agora::rtc::VideoEncoderConfiguration& config)
-{
-	//视频源2在频道内需要取消视频源2的订阅，由视频源1订阅
-	if (joined2) {
-		UpdateVideoSource2Subscribe(false);
-	}
-	agora::rtc::ChannelMediaOptions option;
-	option.autoSubscribeAudio = true;
-	option.autoSubscribeVideo = true;
-	option.publishAudioTrack = true;
-	option.publishCameraTrack = enableVideo;
-	option.clientRoleType = agora::rtc::CLIENT_ROLE_BROADCASTER;
-	option.channelProfile = agora::CHANNEL_PROFILE_LIVE_BROADCASTING;
-	szChannelId_ = channel;
-	localUid_ = uid;
-	
-	connection_.channelId = szChannelId_.c_str();
-	connection_.localUid = uid;
-	//agora::rtc::IRtcEngineEx* engine = (agora::rtc::IRtcEngineEx*)m_rtcEngine;
+void AgoraRtcEngine::FallBackToSoftwareEncoder()
+{
 	agora::base::AParameter apm(*m_rtcEngine);
-	apm->setParameters("{\"che.video.quick_adapt_network\" : false}");
-	int ret = m_rtcEngineEx->joinChannelEx(token, connection_, option, &m_eventHandler);//joinChannel(token, channel, uid, option);
+	apm->setInt("che.hardware_encoding", 0);
+	emit encoderChanged(ENCODER_SOFTWARE);
+}
+
+bool AgoraRtcEngine::VideoSource1JoinChannel(bool enableVideo, const char* token, const char* channel, agora::rtc::uid_t uid, const agora::rtc::VideoEncoderConfiguration& config)
+{
+	//视频源1加入后由视频源1订阅远端用户
+	VideoSource* source = videoSources_.Get(VIDEO_SOURCE_CAMERA_PRIMARY);
+	source->publishAudio = true;
+	source->publishVideo = enableVideo;
+	source->encoderConfig = config;
+	source->hasEncoderConfig = true;
+	//without a choice in the settings the sdk keeps its own encoder
+	if (setting.encoder_type != ENCODER_DEFAULT)
+		SetEncoderType(setting.encoder_type);
+	encoderBackend_.SetTargetFps(config.frameRate);
+	int ret = JoinVideoSource(VIDEO_SOURCE_CAMERA_PRIMARY, token, channel, uid);
 	if (ret == 0) {
-		m_rtcEngineEx->muteRemoteAudioStreamEx(setting.userInfo.uid, true, connection2_);
-		m_rtcEngineEx->muteRemoteVideoStreamEx(setting.userInfo.uid, true, connection2_);
-		if (joined2) {
-			m_rtcEngineEx->muteRemoteAudioStreamEx(setting.userInfo.uid, true, connection2_);
-			m_rtcEngineEx->muteRemoteVideoStreamEx(setting.userInfo.uid, true, connection2_);
-		}
+		encoder_.SetEnabled(setting.adaptiveEncoder);
+		encoder_.SetTarget(config);
 	}
-	m_rtcEngineEx->setVideoEncoderConfigurationEx(config, connection_);
-	
-	videoSource1Subscribe = true;
-	
 	return ret == 0 ? TRUE : FALSE;
 }
 
 void AgoraRtcEngine::SetVideoEncoderConfigurationEx(agora::rtc::VideoEncoderConfiguration config)
 {
-	m_rtcEngineEx->setVideoEncoderConfigurationEx(config, connection_);
+	SetVideoSourceEncoderConfiguration(VIDEO_SOURCE_CAMERA_PRIMARY, config);
+	//a new choice in the settings restarts the ladder from the top
+	if (IsJoined()) {
+		encoder_.SetTarget(config);
+		encoderBackend_.SetTargetFps(config.frameRate);
+	}
 }
 
-int AgoraRtcEngine::VideoSource2JoinChannel(bool enableVideo, const char* token, const char* channel, agora::rtc::uid_t uid, bool subscribeAudio, bool subscribeVideo )
+void AgoraRtcEngine::ApplyAdaptedEncoderConfiguration(const agora::rtc::VideoEncoderConfiguration& config)
 {
-	agora::rtc::ChannelMediaOptions option;
-	option.autoSubscribeAudio = subscribeAudio;
-	option.autoSubscribeVideo = subscribeVideo;
-	option.publishAudioTrack = false;
-	option.publishCameraTrack = false;
-	option.publishMediaPlayerVideoTrack = true;
-	option.publishMediaPlayerAudioTrack = true;
-	option.publishMediaPlayerId = media_player_->getMediaPlayerId();
-	option.clientRoleType = agora::rtc::CLIENT_ROLE_BROADCASTER;
-	option.channelProfile = agora::CHANNEL_PROFILE_LIVE_BROADCASTING;
-	
-	szChannelId_ = channel;
-	connection2_.channelId = szChannelId_.c_str();
-	connection2_.localUid = uid;
-	m_eventHandler2.bEx = true;
-	agora::base::AParameter apm(*m_rtcEngine);
-	apm->setParameters("{\"che.video.quick_adapt_network\" : false}");
-	int ret = m_rtcEngineEx->joinChannelEx(token, connection2_, option, &m_eventHandler2);
-	if (ret == 0) {
-		if (joined) {
-			m_rtcEngineEx->muteRemoteAudioStreamEx(setting.userInfo2.uid, true, connection_);
-			m_rtcEngineEx->muteRemoteVideoStreamEx(setting.userInfo2.uid, true, connection_);
-		}
-		m_rtcEngineEx->muteRemoteAudioStreamEx(setting.userInfo.uid, true, connection2_);
-		m_rtcEngineEx->muteRemoteVideoStreamEx(setting.userInfo.uid, true, connection2_);
-	}
-	if (!joined) videoSource1Subscribe = false;
-	return ret;
+	//source->encoderConfig keeps the target for the next join
+	VideoSource* source = videoSources_.Get(VIDEO_SOURCE_CAMERA_PRIMARY);
+	if (!m_rtcEngineEx || !source->IsJoined())
+		return;
+	m_rtcEngineEx->setVideoEncoderConfigurationEx(config, source->Connection());
+	encoderBackend_.SetTargetFps(config.frameRate);
+}
+
+int AgoraRtcEngine::VideoSource2JoinChannel(bool enableVideo, const char* token, const char* channel, agora::rtc::uid_t uid)
+{
+	VideoSource* source = videoSources_.Get(VIDEO_SOURCE_MEDIA_PLAYER);
+	source->publishAudio = true;
+	source->publishVideo = true;
+	return JoinVideoSource(VIDEO_SOURCE_MEDIA_PLAYER, token, channel, uid);
 }
 
 bool AgoraRtcEngine::EnableVolumeIndication(int interval, int smooth)
@@ -323,39 +582,24 @@ void AgoraRtcEngine::MuteAllRemoteAudio(bool bMute)
 
 void AgoraRtcEngine::MuteRemoteVideo(unsigned int uid, bool bMute)
 {
-	
-	m_rtcEngineEx->muteRemoteVideoStreamEx(uid, bMute, connection_);
+	subscriptions_.SetRemoteVideoMuted(uid, bMute);
 }
 void AgoraRtcEngine::MuteRemoteAudio(unsigned int uid, bool bMute)
 {
-	m_rtcEngineEx->muteRemoteAudioStreamEx(uid, bMute, connection_);
+	subscriptions_.SetRemoteAudioMuted(uid, bMute);
 }
 
 void AgoraRtcEngine::MuteLocalVideo(bool bMute)
 {
-	agora::rtc::ChannelMediaOptions option;
-	option.autoSubscribeAudio = true;
-	option.autoSubscribeVideo = true;
-	option.publishAudioTrack = !muteLocalAudio_;
-	option.publishCameraTrack = !bMute;
 	muteLocalVideo_ = bMute;
-	option.clientRoleType = agora::rtc::CLIENT_ROLE_BROADCASTER;
-	option.channelProfile = agora::CHANNEL_PROFILE_LIVE_BROADCASTING;
-	
-	m_rtcEngineEx->updateChannelMediaOptionsEx(option, connection_);
+	videoSources_.Get(VIDEO_SOURCE_CAMERA_PRIMARY)->publishVideo = !bMute;
+	UpdateVideoSourceOptions(VIDEO_SOURCE_CAMERA_PRIMARY);
 }
 void AgoraRtcEngine::MuteLocalAudio(bool bMute)
 {
-	agora::rtc::ChannelMediaOptions option;
-	option.autoSubscribeAudio = true;
-	option.autoSubscribeVideo = true;
-	option.publishAudioTrack = !bMute;
-	option.publishCameraTrack = muteLocalVideo_;
 	muteLocalAudio_ = bMute;
-	option.clientRoleType = agora::rtc::CLIENT_ROLE_BROADCASTER;
-	option.channelProfile = agora::CHANNEL_PROFILE_LIVE_BROADCASTING;
-
-	m_rtcEngineEx->updateChannelMediaOptionsEx(option, connection_);
+	videoSources_.Get(VIDEO_SOURCE_CAMERA_PRIMARY)->publishAudio = !bMute;
+	UpdateVideoSourceOptions(VIDEO_SOURCE_CAMERA_PRIMARY);
 }
 
 void AgoraRtcEngine::StartPrimary()
@@ -363,9 +607,8 @@ void AgoraRtcEngine::StartPrimary()
 	agora::rtc::CameraCapturerConfiguration config;
 	//config.cameraDirection = agora::rtc::CAMERA_FRONT;
 	//strcpy(config.deviceId,  setting.videoSource1Id.toStdString().c_str());
-	config.format.width = setting.resolution[setting.resIndex].width;
-	config.format.height = setting.resolution[setting.resIndex].height;
-	config.format.fps = setting.frameRate;
+	SelectCameraFormat(setting.videoSource1Id, setting.resolution[setting.resIndex].width,
+		setting.resolution[setting.resIndex].height, setting.frameRate, config.format);
 	int ret = m_rtcEngine->startPrimaryCameraCapture(config);
 }
 
@@ -412,16 +655,12 @@ void AgoraRtcEngine::SetFecParameter(int fec)
 
 int AgoraRtcEngine::OpenVideoSource2(QString url)
 {
-	if (!media_player_)
-		return -1;
-	return media_player_->open(url.toStdString().c_str(), 0);
+	return player_.Open(url, false);
 }
 
 int AgoraRtcEngine::PlayVideoSource2()
 {
-	if (!media_player_)
-		return -1;
-	return media_player_->play();
+	return player_.Play();
 }
 
 int AgoraRtcEngine::ShowVideoSource2(agora::media::base::view_t view)
@@ -433,60 +672,219 @@ int AgoraRtcEngine::ShowVideoSource2(agora::media::base::view_t view)
 
 int AgoraRtcEngine::StopVideoSource2()
 {
-	return media_player_->stop();
+	return player_.Stop();
 }
 
 int AgoraRtcEngine::PauseVideoSource2(bool bPause)
 {
-	if (bPause)
-		return media_player_->pause();
-	else
-		return media_player_->resume();
+	return player_.Pause(bPause);
 }
 
 int AgoraRtcEngine::VideoSourceLeave(const char* channel, unsigned int  uid)
 {
-	agora::rtc::IRtcEngineEx* engine = (agora::rtc::IRtcEngineEx*)m_rtcEngine;
-	agora::rtc::RtcConnection connection;
-	connection.channelId = channel;
-	connection.localUid = uid;
-	int ret = engine->leaveChannelEx(connection);
-
-	if (setting.userInfo.uid == uid)
-		videoSource1Subscribe = false;
-	else if(!joined)
-		videoSource1Subscribe = false;
-	return ret;
+	VideoSource* source = videoSources_.FindByUid(uid);
+	if (!source)
+		return -1;
+	return LeaveVideoSource(source->Kind());
 }
 
 void AgoraRtcEngine::SetVideoWidget(QMap<unsigned int, VideoWidget*> widgets)
 {
+	QMutexLocker lockGrab(&mtxGrab_);
 	QMutexLocker lockMap(&mtxVideos_);
 	videoWidgets_ = widgets;
 }
 
+void AgoraRtcEngine::SetSnapshotMonitor(bool enabled)
+{
+	if (enabled && !QDir().mkpath(snapshotDir_)) {
+		qDebug() << "snapshots: cannot create" << snapshotDir_;
+		return;
+	}
+	snapshots_.SetPeriodic(enabled ? SNAPSHOT_MONITOR_MS : 0, SNAPSHOT_MONITOR_WIDTH, SNAPSHOT_MONITOR_HEIGHT);
+}
+
+void AgoraRtcEngine::SetSourceColorInfo(VIDEO_SOURCE_KIND kind, const VideoColorInfo& color)
+{
+	videoSources_.Get(kind)->SetColorInfo(color);
+}
+
+//called from the snapshot thread. The widget is looked up under the map lock and grabbed
+//outside it, so frame delivery is not held up by the scaling; mtxGrab_ keeps the setters
+//from dropping the widget from the maps until the grab is done.
+bool AgoraRtcEngine::GrabVideoFrame(unsigned int uid, int width, int height, QImage& image)
+{
+	QMutexLocker lockGrab(&mtxGrab_);
+	VideoWidget* widget = nullptr;
+	{
+		QMutexLocker lockMap(&mtxVideos_);
+		widget = videoWidgets_.value(uid, nullptr);
+	}
+	if (!widget) {
+		QMutexLocker lockMap(&mtxVideosEx_);
+		widget = videoWidgetsEx_.value(uid, nullptr);
+	}
+	return widget && widget->GrabFrame(width, height, image);
+}
+
+bool AgoraRtcEngine::StartRecording(const QString& directory, bool includeRemote, RECORD_FORMAT format)
+{
+	bool started = !recorder_.IsRecording();
+	recordRemote_ = includeRemote;
+	if (!recorder_.Start(directory, format))
+		return false;
+	if (started)
+		emit recordingChanged(true, false);
+	return true;
+}
+
+void AgoraRtcEngine::StopRecording()
+{
+	bool stopped = recorder_.IsRecording();
+	recorder_.Stop();
+	if (stopped)
+		emit recordingChanged(false, false);
+}
+
+bool AgoraRtcEngine::SetRecording(RECORD_FORMAT format, bool enabled)
+{
+	if (recorder_.IsRecording() && recorder_.Format() != format)
+		return false;
+	if (!enabled) {
+		StopRecording();
+		return true;
+	}
+	if (format == RECORD_FORMAT_CAPTURE)
+		return StartRecording(QCoreApplication::applicationDirPath() + "/captures", true, format);
+	return StartRecording(QCoreApplication::applicationDirPath() + "/recordings");
+}
+
+QList<unsigned int> AgoraRtcEngine::RenderedUids()
+{
+	QList<unsigned int> uids;
+	{
+		QMutexLocker lockMap(&mtxVideos_);
+		uids = videoWidgets_.keys();
+	}
+	QMutexLocker lockMap(&mtxVideosEx_);
+	QList<unsigned int> uidsEx = videoWidgetsEx_.keys();
+	for (int i = 0; i < uidsEx.size(); ++i) {
+		if (!uids.contains(uidsEx[i]))
+			uids.append(uidsEx[i]);
+	}
+	return uids;
+}
+
 void AgoraRtcEngine::ResetVideoWidgets()
 {
+	QMutexLocker lockGrab(&mtxGrab_);
 	QMutexLocker lockMap(&mtxVideos_);
 	videoWidgets_.clear();
 }
 
 void AgoraRtcEngine::SetVideoWidgetEx(QMap<unsigned int, VideoWidget*> widgets)
 {
+	QMutexLocker lockGrab(&mtxGrab_);
 	QMutexLocker lockMap(&mtxVideosEx_);
 	videoWidgetsEx_ = widgets;
 }
 
 void AgoraRtcEngine::ResetVideoWidgetsEx()
 {
+	QMutexLocker lockGrab(&mtxGrab_);
 	QMutexLocker lockMap(&mtxVideosEx_);
 	videoWidgetsEx_.clear();
 }
 
+bool AgoraRtcEngine::GetConnectionStats(unsigned int localUid, ConnectionStats& stats)
+{
+	QMutexLocker lock(&mtxStats_);
+	auto iter = connectionStats_.find(localUid);
+	if (iter == connectionStats_.end())
+		return false;
+	stats = iter.value();
+	return true;
+}
+
+void AgoraRtcEngine::UpdateRtcStats(const agora::rtc::RtcConnection& connection, const agora::rtc::RtcStats& stats)
+{
+	{
+		QMutexLocker lock(&mtxStats_);
+		ConnectionStats& connStats = connectionStats_[connection.localUid];
+		connStats.channelId = connection.channelId ? connection.channelId : "";
+		connStats.localUid = connection.localUid;
+		connStats.rtcStats = stats;
+	}
+	if (IsPrimaryConnection(connection))
+		encoder_.OnRtcStats(stats);
+	emit rtcStatsUpdated(connection.localUid);
+}
+
+void AgoraRtcEngine::UpdateLocalVideoStats(const agora::rtc::RtcConnection& connection, const agora::rtc::LocalVideoStats& stats)
+{
+	{
+		QMutexLocker lock(&mtxStats_);
+		connectionStats_[connection.localUid].localVideoStats = stats;
+	}
+	//the recorder takes the frames as captured
+	recorder_.SetFrameRate(connection.localUid, stats.captureFrameRate);
+	if (IsPrimaryConnection(connection)) {
+		encoder_.OnLocalVideoStats(stats);
+		if (encoderBackend_.OnLocalVideoStats(stats)) {
+			encoderBackend_.OnFallBack();
+			QMetaObject::invokeMethod(this, [this]() {
+				FallBackToSoftwareEncoder();
+			}, Qt::QueuedConnection);
+		}
+	}
+	emit localVideoStatsUpdated(connection.localUid);
+}
+
+void AgoraRtcEngine::UpdateRemoteVideoStats(const agora::rtc::RtcConnection& connection, const agora::rtc::RemoteVideoStats& stats)
+{
+	{
+		QMutexLocker lock(&mtxStats_);
+		connectionStats_[connection.localUid].remoteVideoStats[stats.uid] = stats;
+	}
+	recorder_.SetFrameRate(stats.uid, stats.decoderOutputFrameRate);
+	emit remoteVideoStatsUpdated(connection.localUid, stats.uid);
+}
+
+void AgoraRtcEngine::UpdateNetworkQuality(const agora::rtc::RtcConnection& connection, int txQuality, int rxQuality)
+{
+	if (IsPrimaryConnection(connection))
+		encoder_.OnNetworkQuality(txQuality);
+	QMutexLocker lock(&mtxStats_);
+	ConnectionStats& connStats = connectionStats_[connection.localUid];
+	connStats.txQuality = txQuality;
+	connStats.rxQuality = rxQuality;
+}
+
+void AgoraRtcEngine::ClearConnectionStats(const agora::rtc::RtcConnection& connection)
+{
+	QMutexLocker lock(&mtxStats_);
+	connectionStats_.remove(connection.localUid);
+}
+
+void AgoraRtcEngine::ClearRemoteVideoStats(const agora::rtc::RtcConnection& connection, unsigned int remoteUid)
+{
+	QMutexLocker lock(&mtxStats_);
+	auto iter = connectionStats_.find(connection.localUid);
+	if (iter != connectionStats_.end())
+		iter.value().remoteVideoStats.remove(remoteUid);
+}
+
+bool AgoraRtcEngine::IsPrimaryConnection(const agora::rtc::RtcConnection& connection)
+{
+	VideoSource* source = videoSources_.Get(VIDEO_SOURCE_CAMERA_PRIMARY);
+	return source && source->IsJoined() && source->Uid() == connection.localUid;
+}
+
 
 void AgoraRtcEngine::onPlayerSourceStateChanged(agora::media::base::MEDIA_PLAYER_STATE state,
 	agora::media::base::MEDIA_PLAYER_ERROR ec)
 {
+	player_.OnStateChanged(state, ec);
 	if (agora::media::base::PLAYER_STATE_OPEN_COMPLETED == state) {
 		emit openPlayerComplete();
 	}
@@ -515,59 +913,74 @@ bool AgoraRtcEngine::RegisterVideoFrameObserver(bool bEnable)
 	return nRet == 0 ? TRUE : FALSE;
 }
 
-bool AgoraRtcEngine::onCaptureVideoFrame(VideoFrame& videoFrame)
+void AgoraRtcEngine::DeliverVideoFrame(unsigned int uid, VideoFrame& videoFrame)
 {
-	if (setting.bExtend) {
-		QMutexLocker lockMap(&mtxVideosEx_);
-		if (videoWidgetsEx_.find(setting.userInfo.uid)
-			== videoWidgetsEx_.end())
-			return true;
-
-		videoWidgetsEx_[setting.userInfo.uid]->CopyVideoFrame(videoFrame);
+	if (uid == 0)
+		return;
+	//the 4.0 VideoFrame carries no color metadata: local sources use the one set in
+	//the video settings, remote streams are taken as BT.601 limited range
+	VideoSource* source = videoSources_.FindByUid(uid);
+	bool local = source != nullptr;
+	VideoColorInfo color = local ? source->ColorInfo() : VideoColorInfo();
+	if (recorder_.IsRecording() && (local || recordRemote_))
+		recorder_.Push(uid, videoFrame, color);
+	//local sources are shown on the extend screen when it is enabled
+	bool extend = setting.bExtend && local;
+	QMutex& mtx = extend ? mtxVideosEx_ : mtxVideos_;
+	QMap<unsigned int, VideoWidget*>& widgets = extend ? videoWidgetsEx_ : videoWidgets_;
+	{
+		QMutexLocker lockMap(&mtx);
+		auto iter = widgets.find(uid);
+		if (iter == widgets.end())
+			return;
+		iter.value()->CopyVideoFrame(videoFrame, color);
 	}
-	else {
-		QMutexLocker lockMap(&mtxVideos_);
-		if (videoWidgets_.find(setting.userInfo.uid)
-			== videoWidgets_.end())
-			return true;
+	emit renderSignal();
+}
 
-		videoWidgets_[setting.userInfo.uid]->CopyVideoFrame(videoFrame);
+//settings dialog preview, shares the tile copy instead of an sdk view
+void AgoraRtcEngine::DeliverPreviewFrame(VideoFrame& videoFrame)
+{
+	{
+		QMutexLocker lock(&mtxPreview_);
+		if (!previewWidget_)
+			return;
+		previewWidget_->CopyVideoFrame(videoFrame, videoSources_.Get(VIDEO_SOURCE_CAMERA_PRIMARY)->ColorInfo());
 	}
 	emit renderSignal();
+}
+
+bool AgoraRtcEngine::onCaptureVideoFrame(VideoFrame& videoFrame)
+{
+	//local preview is a capture frame scaled down to the tile, never the sdk renderer
+	DeliverVideoFrame(videoSources_.Get(VIDEO_SOURCE_CAMERA_PRIMARY)->Uid(), videoFrame);
+	DeliverPreviewFrame(videoFrame);
 	return true;
 }
 
-bool AgoraRtcEngine::onMediaPlayerVideoFrame(VideoFrame& videoFrame, int mediaPlayerId)
+bool AgoraRtcEngine::onSecondaryCameraCaptureVideoFrame(VideoFrame& videoFrame)
 {
-	if (setting.bExtend) {
-		QMutexLocker lockMap(&mtxVideosEx_);
-		if (videoWidgetsEx_.find(setting.userInfo2.uid)
-			== videoWidgetsEx_.end())
-			return true;
+	DeliverVideoFrame(videoSources_.Get(VIDEO_SOURCE_CAMERA_SECONDARY)->Uid(), videoFrame);
+	return true;
+}
 
-		videoWidgetsEx_[setting.userInfo2.uid]->CopyVideoFrame(videoFrame);
-	}
-	else {
-		QMutexLocker lockMap(&mtxVideos_);
-		if (videoWidgets_.find(setting.userInfo2.uid)
-			== videoWidgets_.end())
-			return true;
+bool AgoraRtcEngine::onScreenCaptureVideoFrame(VideoFrame& videoFrame)
+{
+	DeliverVideoFrame(videoSources_.Get(VIDEO_SOURCE_SCREEN)->Uid(), videoFrame);
+	return true;
+}
 
-		videoWidgets_[setting.userInfo2.uid]->CopyVideoFrame(videoFrame);
-	}
-	emit renderSignal();
+bool AgoraRtcEngine::onMediaPlayerVideoFrame(VideoFrame& videoFrame, int mediaPlayerId)
+{
+	DeliverVideoFrame(videoSources_.Get(VIDEO_SOURCE_MEDIA_PLAYER)->Uid(), videoFrame);
 	return true;
 }
 
 bool AgoraRtcEngine::onRenderVideoFrame(const char* channelId, agora::rtc::uid_t remoteUid, VideoFrame& videoFrame)
 {
-	QMutexLocker lockMap(&mtxVideos_);
-	if (videoWidgets_.find(remoteUid)
-		== videoWidgets_.end())
-		return true;
-	if (remoteUid != setting.userInfo2.uid)
-		videoWidgets_[remoteUid]->CopyVideoFrame(videoFrame);
-	emit renderSignal();
+	//local sources are rendered from their capture/player callbacks
+	if (!videoSources_.IsLocalUid(remoteUid))
+		DeliverVideoFrame(remoteUid, videoFrame);
 	return true;
 }
 
@@ -582,21 +995,10 @@ void AgoraRtcEngine::InitAudioDevice()
 		audioManager_ = NULL;
 		return;
 	}
-	mics_ = (*audioManager_)->enumerateRecordingDevices();
-	speakers_ = (*audioManager_)->enumeratePlaybackDevices();
-	
 }
 
 void AgoraRtcEngine::DestroyAudioDevice()
 {  
-	if (mics_) {
-		mics_->release();
-		mics_ = NULL;
-	}
-	if (speakers_) {
-		speakers_->release();
-		speakers_ = NULL;
-	}
 	if (audioManager_ != NULL) {
 		delete audioManager_;
 		audioManager_ = NULL;
@@ -611,14 +1013,9 @@ void AgoraRtcEngine::InitVideoDevice()
 		videoManager_ = NULL;
 		return;
 	}
-	videos_ = (*videoManager_)->enumerateVideoDevices();
 }
 void AgoraRtcEngine::DestroyVideoDevice()
 {
-	if (videos_) {
-		videos_->release();
-		videos_ = NULL;
-	}
 	if (videoManager_ != NULL) {
 		delete videoManager_;
 		videoManager_ = NULL;
@@ -643,10 +1040,7 @@ bool AgoraRtcEngine::SetMicVolume(int nVol)
 
 int  AgoraRtcEngine::GetMicCount()
 {
-	if (mics_ != NULL)
-		return (int)mics_->getCount();
-
-	return 0;
+	return devices_.Count(DEVICE_MIC);
 }
 
 QString AgoraRtcEngine::GetCurMicID()
@@ -670,19 +1064,7 @@ bool AgoraRtcEngine::GetMic(int nIndex, QString& rDeviceName, QString& rDeviceID
 {
 	rDeviceName.clear();
 	rDeviceID.clear();
-	char szDeviceName[agora::rtc::MAX_DEVICE_ID_LENGTH];
-	char szDeviceID[agora::rtc::MAX_DEVICE_ID_LENGTH];
-
-	if (nIndex >= GetMicCount())
-		return FALSE;
-
-	int nRet = mics_->getDevice(nIndex, szDeviceName, szDeviceID);
-	if (nRet != 0)
-		return FALSE;
-
-	rDeviceName = QString::fromUtf8(szDeviceName);
-	rDeviceID = QString::fromUtf8(szDeviceID);
-	return TRUE;
+	return devices_.Device(DEVICE_MIC, nIndex, rDeviceName, rDeviceID);
 }
 
 void AgoraRtcEngine::TestMicDevice(bool bTestOn)
@@ -717,10 +1099,7 @@ bool AgoraRtcEngine::SetSpeakerVolume(int nVol)
 
 int  AgoraRtcEngine::GetSpeakerCount()
 {
-	if (speakers_ != NULL)
-		return (int)speakers_->getCount();
-
-	return 0;
+	return devices_.Count(DEVICE_SPEAKER);
 }
 
 QString AgoraRtcEngine::GetCurSpeakerID()
@@ -744,19 +1123,7 @@ bool AgoraRtcEngine::GetSpeaker(int nIndex, QString& rDeviceName, QString& rDevi
 {
 	rDeviceName.clear();
 	rDeviceID.clear();
-	char szDeviceName[agora::rtc::MAX_DEVICE_ID_LENGTH];
-	char szDeviceID[agora::rtc::MAX_DEVICE_ID_LENGTH];
-
-	if (nIndex >= GetSpeakerCount())
-		return FALSE;
-
-	int nRet = speakers_->getDevice(nIndex, szDeviceName, szDeviceID);
-	if (nRet != 0)
-		return FALSE;
-
-	rDeviceName = QString::fromUtf8(szDeviceName);
-	rDeviceID = QString::fromUtf8(szDeviceID);
-	return TRUE;
+	return devices_.Device(DEVICE_SPEAKER, nIndex, rDeviceName, rDeviceID);
 }
 
 void AgoraRtcEngine::TestSpeakerDevice(bool bTestOn)
@@ -776,10 +1143,7 @@ void AgoraRtcEngine::TestSpeakerDevice(bool bTestOn)
 
 int AgoraRtcEngine::GetVideoDeviceCount()
 {
-	if (videos_ == NULL)
-		return 0;
-
-	return (int)videos_->getCount();
+	return devices_.Count(DEVICE_CAMERA);
 }
 
 QString AgoraRtcEngine::GetCurVideoDeviceID()
@@ -810,22 +1174,7 @@ bool AgoraRtcEngine::GetVideoDevice(int nIndex, QString& rDeviceName, QString& r
 {
 	rDeviceName.clear();
 	rDeviceID.clear();
-	char szDeviceName[agora::rtc::MAX_DEVICE_ID_LENGTH];
-	char szDeviceID[agora::rtc::MAX_DEVICE_ID_LENGTH];
-
-	if (nIndex >= GetVideoDeviceCount())
-		return FALSE;
-
-	if (videos_ == NULL)
-		return FALSE;
-
-	int nRet = videos_->getDevice(nIndex, szDeviceName, szDeviceID);
-	if (nRet != 0)
-		return FALSE;
-
-	rDeviceName = QString::fromUtf8(szDeviceName);
-	rDeviceID = QString::fromUtf8(szDeviceID);
-	return TRUE;
+	return devices_.Device(DEVICE_CAMERA, nIndex, rDeviceName, rDeviceID);
 }
 void AgoraRtcEngine::GetVideoDeviceInfo(QVector<agora::rtc::VideoFormat>& infos)
 {
@@ -836,22 +1185,41 @@ void AgoraRtcEngine::GetVideoDeviceInfo(QVector<agora::rtc::VideoFormat>& infos)
 			(*videoManager_)->getDevice(szDeviceID);
 			curVideoDevice = QString::fromUtf8(szDeviceID);
 		}
-		int count = (*videoManager_)->numberOfCapabilities(curVideoDevice.toStdString().c_str());//(szDeviceID);
-		for (int i = 0; i < count; ++i) {
-			agora::rtc::VideoFormat format;
-			(*videoManager_)->getCapability(curVideoDevice.toStdString().c_str(), i, format);
-			if (format.width == 1280 && format.height == 720 && format.fps == 30) {
-				infos.push_back(format);
-			}
-			else if (format.width == 1920 && format.height == 1080 && format.fps == 30) {
-				infos.push_back(format);
-			}
-			else if (format.width == 1920 && format.height == 1080 && format.fps == 60) {
-				infos.push_back(format);
-			}
-			else if (format.width == 3840 && format.height == 2160 && format.fps == 60) {
-				infos.push_back(format);
-			}
-		}
 	}
+	//the settings page steps through 16:9 modes from 720p at 30 or 60 fps
+	QVector<agora::rtc::VideoFormat> matrix = cameraFormatMatrix(GetCameraFormats(curVideoDevice));
+	for (const agora::rtc::VideoFormat& format : matrix) {
+		if (format.width * 9 == format.height * 16 && format.height >= 720
+			&& (format.fps == 30 || format.fps == 60))
+			infos.push_back(format);
+	}
+}
+
+QVector<agora::rtc::VideoFormat> AgoraRtcEngine::GetCameraFormats(const QString& deviceId)
+{
+	QString id = deviceId.isEmpty() ? curVideoDevice : deviceId;
+	if (id.isEmpty()) {
+		//the sdk captures the first camera until one is selected
+		QString name;
+		devices_.Device(DEVICE_CAMERA, 0, name, id);
+	}
+	return devices_.Formats(id);
+}
+
+bool AgoraRtcEngine::SelectCameraFormat(const QString& deviceId, int width, int height, int fps, agora::rtc::VideoFormat& format)
+{
+	format.width = width;
+	format.height = height;
+	format.fps = fps;
+	QVector<agora::rtc::VideoFormat> formats = GetCameraFormats(deviceId);
+	int index = selectCameraFormat(formats, width, height, fps);
+	if (index < 0) {
+		qDebug() << "camera" << deviceId << "reports no formats, capturing" << width << "x" << height << "@" << fps;
+		return false;
+	}
+	format = formats[index];
+	qDebug() << "camera" << deviceId << "target" << width << "x" << height << "@" << fps
+		<< "capture" << format.width << "x" << format.height << "@" << format.fps
+		<< "cost" << cameraFormatCost(format, width, height, fps);
+	return true;
 }
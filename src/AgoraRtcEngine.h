@@ -10,38 +10,87 @@
 #include <QMap>
 #include <QMutex>
 #include <QObject>
+#include <atomic>
 #include <memory>
+#include <thread>
 
 #include "AgoraEnv.h"
+#include "DeviceRegistry.h"
+#include "EncoderBackend.h"
+#include "EncoderController.h"
+#include "FrameRecorder.h"
+#include "MediaPlayerController.h"
+#include "SnapshotService.h"
+#include "SubscriptionCoordinator.h"
+#include "VideoSource.h"
+#include "video_frame_copy.h"
 
 
 #define _400_PREVIEW_5 0
 class AgoraRtcEngineEvent;
 class AgoraRtcEngineEventEx;
 class VideoWidget;
+
+//latest statistics reported on one RtcConnection, keyed by its local uid
+typedef struct tagConnectionStats
+{
+	std::string channelId;
+	agora::rtc::uid_t localUid = 0;
+	agora::rtc::RtcStats rtcStats;
+	agora::rtc::LocalVideoStats localVideoStats;
+	QMap<unsigned int, agora::rtc::RemoteVideoStats> remoteVideoStats;
+	int txQuality = 0;
+	int rxQuality = 0;
+}ConnectionStats;
+
 class AgoraRtcEngine : public QObject, public agora::media::IVideoFrameObserver
 	, public agora::rtc::IMediaPlayerSourceObserver
 {
 	Q_OBJECT
-
+	friend class AgoraRtcEngineEventEx;
 public:
 	AgoraRtcEngine(QObject *parent = NULL);
 	~AgoraRtcEngine();
 	static AgoraRtcEngine* GetAgoraRtcEngine();
 	static agora::rtc::IRtcEngineEx* GetEngine();
 	int Init();
-	bool IsJoined() { return joined; }
-	void SetJoined(bool b) { joined = b; }
-	bool IsJoined2() { 
-		return joined2; 
-	}
-	void SetJoined2(bool b) { joined2 = b; }
-	bool LocalVideoPreview(HWND hVideoWnd, bool bPreviewOn = TRUE, agora::media::base::RENDER_MODE_TYPE mode = agora::media::base::RENDER_MODE_TYPE::RENDER_MODE_HIDDEN);
+	//Init on a worker thread, engineReady is emitted when it returns
+	void InitAsync();
+	//waits for InitAsync, or runs Init when it was never started; returns the Init result
+	int WaitInit();
+	bool IsInitialized() { return initDone_; }
+	bool IsJoined() { return IsVideoSourceJoined(VIDEO_SOURCE_CAMERA_PRIMARY); }
+	void SetJoined(bool b) { SetVideoSourceJoined(VIDEO_SOURCE_CAMERA_PRIMARY, b); }
+	bool IsJoined2() { return IsVideoSourceJoined(VIDEO_SOURCE_MEDIA_PLAYER); }
+	void SetJoined2(bool b) { SetVideoSourceJoined(VIDEO_SOURCE_MEDIA_PLAYER, b); }
+	//video sources, VideoSource1*/VideoSource2* are kept for the camera and the media player
+	VideoSource* GetVideoSource(VIDEO_SOURCE_KIND kind) { return videoSources_.Get(kind); }
+	bool IsLocalUid(unsigned int uid) { return videoSources_.IsLocalUid(uid); }
+	bool IsVideoSourceJoined(VIDEO_SOURCE_KIND kind);
+	void SetVideoSourceJoined(VIDEO_SOURCE_KIND kind, bool b);
+	int JoinVideoSource(VIDEO_SOURCE_KIND kind, const char* token, const char* channel, agora::rtc::uid_t uid);
+	int LeaveVideoSource(VIDEO_SOURCE_KIND kind);
+	int UpdateVideoSourceOptions(VIDEO_SOURCE_KIND kind);
+	int SetVideoSourceEncoderConfiguration(VIDEO_SOURCE_KIND kind, const agora::rtc::VideoEncoderConfiguration& config);
+	int SendVideoSourceStreamMessage(VIDEO_SOURCE_KIND kind, QString message);
+	int StartVideoSourceCapture(VIDEO_SOURCE_KIND kind);
+	int StopVideoSourceCapture(VIDEO_SOURCE_KIND kind);
+	//document camera and screen share, the dialogs leave the camera and the player themselves
+	void LeaveExtraVideoSources();
+	//joins or leaves the document camera / screen share as the settings say, a new
+	//document camera device restarts the capture; true when it joined or left
+	bool SyncVideoSource(VIDEO_SOURCE_KIND kind, bool enabled, const QString& channel, unsigned int uid);
+	//capture frames are copied into widget, an sdk rendered view is only set up when hSdkView is given
+	bool LocalVideoPreview(VideoWidget* widget, bool bPreviewOn = TRUE, HWND hSdkView = NULL, agora::media::base::RENDER_MODE_TYPE mode = agora::media::base::RENDER_MODE_TYPE::RENDER_MODE_HIDDEN);
+	//ENCODER_TYPE of the camera, software when the gpu is missing or refuses; false then.
+	//only called for a type chosen in the settings, ENCODER_DEFAULT leaves the sdk alone
 	bool SetEncoderType(int type);
+	//requested and active encoder of the current camera session, shown in the video settings
+	EncoderReport GetEncoderReport() { return encoderBackend_.Report(); }
 	void VideoSource1SendStreamMessage(QString message);
 	void VideoSource2SendStreamMessage(QString message);
 	bool VideoSource1JoinChannel(bool enableVideo, const char* token, const char* channel,  agora::rtc::uid_t uid, const agora::rtc::VideoEncoderConfiguration & config);
-	int VideoSource2JoinChannel(bool enableVideo, const char* token, const char* channel, agora::rtc::uid_t uid, bool subscribeAudio, bool subscribeVideo);
+	int VideoSource2JoinChannel(bool enableVideo, const char* token, const char* channel, agora::rtc::uid_t uid);
 
 	void SetVideoEncoderConfigurationEx(agora::rtc::VideoEncoderConfiguration config);
 	bool EnableVolumeIndication(int interval , int smooth);
@@ -61,14 +110,14 @@ public:
 	//IVideoFrameObserver
 	bool RegisterVideoFrameObserver(bool bEnable);
 	virtual bool onCaptureVideoFrame(VideoFrame& videoFrame) override;
-	virtual bool onSecondaryCameraCaptureVideoFrame(VideoFrame& videoFrame) override { return true; }
-	virtual bool onScreenCaptureVideoFrame(VideoFrame& videoFrame) override { return true; }
+	virtual bool onSecondaryCameraCaptureVideoFrame(VideoFrame& videoFrame) override;
+	virtual bool onScreenCaptureVideoFrame(VideoFrame& videoFrame) override;
 	virtual bool onMediaPlayerVideoFrame(VideoFrame& videoFrame, int mediaPlayerId)override;
 	virtual bool onSecondaryScreenCaptureVideoFrame(VideoFrame& videoFrame) override { return true; }
 	virtual bool onRenderVideoFrame(const char* channelId, agora::rtc::uid_t remoteUid, VideoFrame& videoFrame)override;
 	virtual bool onTranscodedVideoFrame(VideoFrame& videoFrame) override { return true; }
 	virtual bool getMirrorApplied() override  { return true; }
-	//device
+	//device managers of the settings dialogs, the device lists come from DeviceRegistry
 	void InitAudioDevice();
 	void DestroyAudioDevice();
 	void InitVideoDevice();
@@ -96,7 +145,15 @@ public:
 	bool SetCurVideoDevice(const QString deviceID);
 	bool GetVideoDevice(int nIndex, QString& rDeviceName, QString& rDeviceID);
 	void GetVideoDeviceInfo(QVector<agora::rtc::VideoFormat>& infos);
-	//media player
+	//every capture format of a camera, the current camera when deviceId is empty
+	QVector<agora::rtc::VideoFormat> GetCameraFormats(const QString& deviceId = QString());
+	//capture format with the least conversion to the encoder target, see CameraFormats.h;
+	//false when the camera reports no formats, format is the target then
+	bool SelectCameraFormat(const QString& deviceId, int width, int height, int fps, agora::rtc::VideoFormat& format);
+	//called by AgoraRtcEngineEvent on the sdk thread
+	void RefreshDevices(DEVICE_KIND kind) { devices_.RequestRefresh(kind); }
+	//media player, see MediaPlayerController
+	MediaPlayerController* Player() { return &player_; }
 	int OpenVideoSource2(QString url);
 	int PlayVideoSource2();
 	int StopVideoSource2();
@@ -110,12 +167,12 @@ public:
 	void onPlayerSourceStateChanged(agora::media::base::MEDIA_PLAYER_STATE state,
 		agora::media::base::MEDIA_PLAYER_ERROR ec) override;
 
-	virtual void onPositionChanged(int64_t position)  override {}
+	virtual void onPositionChanged(int64_t position)  override { player_.OnPositionChanged(position); }
 
-	virtual void onPlayerEvent(agora::media::base::MEDIA_PLAYER_EVENT eventCode, int64_t elapsedTime, const char* message)  override {}
+	virtual void onPlayerEvent(agora::media::base::MEDIA_PLAYER_EVENT eventCode, int64_t elapsedTime, const char* message)  override { player_.OnPlayerEvent(eventCode); }
 
 	virtual void onMetaData(const void* data, int length) override {}
-	virtual void onPlayBufferUpdated(int64_t playCachedBuffer) override {}
+	virtual void onPlayBufferUpdated(int64_t playCachedBuffer) override { player_.OnBufferUpdated(playCachedBuffer); }
 
 	virtual void onPreloadEvent(const char* src, agora::media::base::PLAYER_PRELOAD_EVENT event)  override {}
 	virtual void onCompleted()  override {}
@@ -127,9 +184,41 @@ public:
 #else
 	virtual void onPlayerIdsRenew(const char* jsonIds) override{}
 #endif
-	bool IsvideoSource1Subscribe(){return videoSource1Subscribe;}
-	void UpdateVideoSource2Subscribe(bool subscribe);
+	bool GetConnectionStats(unsigned int localUid, ConnectionStats& stats);
+	//adaptive encoder of the teacher camera
+	EncoderController* Encoder() { return &encoder_; }
+	//thumbnails of the rendered uids written to log/snapshots/<uid>.jpg, see SnapshotService
+	void SetSnapshotMonitor(bool enabled);
+	//YUV interpretation of a local source's frames, see VideoSource::SetColorInfo
+	void SetSourceColorInfo(VIDEO_SOURCE_KIND kind, const VideoColorInfo& color);
+	bool GrabVideoFrame(unsigned int uid, int width, int height, QImage& image);
+	QList<unsigned int> RenderedUids();
+	//copy of the local sources, remote uids too when includeRemote
+	//RECORD_FORMAT_CAPTURE files are replayed with the frame_replay program
+	bool StartRecording(const QString& directory, bool includeRemote = false, RECORD_FORMAT format = RECORD_FORMAT_Y4M);
+	void StopRecording();
+	bool IsRecording() { return recorder_.IsRecording(); }
+	RECORD_FORMAT RecordingFormat() { return recorder_.Format(); }
+	//starts or stops the recording of format next to the executable: recordings/ for Y4M,
+	//captures/ with the remote streams for RECORD_FORMAT_CAPTURE. false while the other
+	//format records, one recording never stops or replaces the other
+	bool SetRecording(RECORD_FORMAT format, bool enabled);
 private:
+	//called by AgoraRtcEngineEventEx on the sdk thread
+	void UpdateRtcStats(const agora::rtc::RtcConnection& connection, const agora::rtc::RtcStats& stats);
+	void UpdateLocalVideoStats(const agora::rtc::RtcConnection& connection, const agora::rtc::LocalVideoStats& stats);
+	void UpdateRemoteVideoStats(const agora::rtc::RtcConnection& connection, const agora::rtc::RemoteVideoStats& stats);
+	void UpdateNetworkQuality(const agora::rtc::RtcConnection& connection, int txQuality, int rxQuality);
+	void ClearConnectionStats(const agora::rtc::RtcConnection& connection);
+	void ClearRemoteVideoStats(const agora::rtc::RtcConnection& connection, unsigned int remoteUid);
+	bool IsPrimaryConnection(const agora::rtc::RtcConnection& connection);
+	//a step of encoder_, GUI thread
+	void ApplyAdaptedEncoderConfiguration(const agora::rtc::VideoEncoderConfiguration& config);
+	//the hardware encoder failed during the session, GUI thread
+	void FallBackToSoftwareEncoder();
+	agora::rtc::ChannelMediaOptions MediaOptions(VideoSource* source) const;
+	void DeliverVideoFrame(unsigned int uid, VideoFrame& videoFrame);
+	void DeliverPreviewFrame(VideoFrame& videoFrame);
 	
 	void InitVideoFrame();
 	static AgoraRtcEngine agoraRtcEngine;
@@ -137,29 +226,42 @@ private:
 	static agora::rtc::IRtcEngineEx* m_rtcEngineEx;
 	
 	static AgoraRtcEngineEvent m_eventHandler;
+	//each source owns the AgoraRtcEngineEventEx of its connection
+	VideoSourceRegistry videoSources_;
+	SubscriptionCoordinator subscriptions_;
+	QMap<unsigned int, ConnectionStats> connectionStats_;
+	QMutex mtxStats_;
 	agora::agora_refptr<agora::rtc::IMediaPlayer> media_player_ = nullptr;
+	MediaPlayerController player_;
 	//audio device
 	agora::rtc::AAudioDeviceManager* audioManager_ = nullptr;
-	agora::rtc::IAudioDeviceCollection *mics_ = nullptr;
-	agora::rtc::IAudioDeviceCollection *speakers_ = nullptr;
 	//video device
 	agora::rtc::AVideoDeviceManager* videoManager_ = nullptr;
-	agora::rtc::IVideoDeviceCollection* videos_  = nullptr;
+	DeviceRegistry devices_;
+	//device of the running document camera capture
+	QString secondaryCameraId_;
+	EncoderController encoder_;
+	EncoderBackend encoderBackend_;
 	std::map<std::string, std::string> mapVideos_;
 	QMap<unsigned int, VideoWidget*> videoWidgets_;
 	QMap<unsigned int, VideoWidget*> videoWidgetsEx_;
 	QMutex mtxVideos_;
 	QMutex mtxVideosEx_;
-	std::string szChannelId_;
-	agora::rtc::uid_t localUid_;
-	agora::rtc::RtcConnection connection2_;
-	agora::rtc::RtcConnection connection_;
-	bool joined = false;
-	bool joined2 = false;
+	//held by GrabVideoFrame and by the widget map setters, see GrabVideoFrame
+	QMutex mtxGrab_;
+	QString snapshotDir_;
+	VideoWidget* previewWidget_ = nullptr;
+	QMutex mtxPreview_;
+	bool sdkPreviewView_ = false;
+	SnapshotService snapshots_;
+	FrameRecorder recorder_;
+	std::atomic<bool> recordRemote_{ false };
+	std::thread initThread_;
+	std::atomic<bool> initDone_{ false };
+	int initResult_ = -1;
 	
 	bool muteLocalVideo_ = false;
 	bool muteLocalAudio_ = false;
-	bool videoSource1Subscribe = true;
 	QString curVideoDevice = "";
 signals:
 	void userOffline(unsigned int uid, int elapsed);
@@ -167,11 +269,21 @@ signals:
 	void volumeIndication(unsigned int volume, unsigned int speakerNumber, int totalVolume);
 	void joinedChannelSuccess(const char* channel, agora::rtc::uid_t uid, int elapsed);
 	void joinedChannelSuccessEx(const char* channel, agora::rtc::uid_t uid, int elapsed);
+	void rtcStatsUpdated(unsigned int localUid);
+	void localVideoStatsUpdated(unsigned int localUid);
+	void remoteVideoStatsUpdated(unsigned int localUid, unsigned int remoteUid);
 	void renderSignal();
 	void openPlayerComplete();
 	void playerError(int ec);
 	void streamMessage(unsigned int uid, QString name);
 	void leaveChannelSignal();
+	void engineReady(int ret);
+	//a DEVICE_KIND list of DeviceRegistry was enumerated again
+	void devicesChanged(int kind);
+	//ENCODER_TYPE in use by the camera
+	void encoderChanged(int type);
+	//FrameRecorder started or stopped; failed when a write stopped it, emitted on the writer thread
+	void recordingChanged(bool recording, bool failed);
 };
 
 #define rtcEngine AgoraRtcEngine::GetAgoraRtcEngine()
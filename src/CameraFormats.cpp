@@ -0,0 +1,72 @@
+#include "CameraFormats.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+int cameraFormatCost(const agora::rtc::VideoFormat& format, int width, int height, int fps)
+{
+	if (format.width <= 0 || format.height <= 0 || format.fps <= 0
+		|| width <= 0 || height <= 0 || fps <= 0)
+		return INT_MAX;
+	if (format.width == width && format.height == height && format.fps == fps)
+		return CAMERA_FORMAT_EXACT;
+
+	//all terms are percent of the target
+	long long area = (long long)format.width * format.height;
+	long long target = (long long)width * height;
+	int areaOver = area > target ? (int)((area - target) * 100 / target) : 0;
+	int areaShort = area < target ? (int)((target - area) * 100 / target) : 0;
+	int fpsOver = format.fps > fps ? (format.fps - fps) * 100 / fps : 0;
+	int fpsShort = format.fps < fps ? (fps - format.fps) * 100 / fps : 0;
+	long long wide = (long long)format.width * height;
+	long long tall = (long long)format.height * width;
+	int crop = (int)(std::llabs(wide - tall) * 100 / (std::max)(wide, tall));
+
+	//dropping frames is cheaper than scaling, cropping loses field of view
+	int cost = 1 + fpsOver / 4 + areaOver + crop * 2;
+	if (format.width < width || format.height < height || areaShort > 0 || fpsShort > 0)
+		cost += CAMERA_FORMAT_SHORT + (areaShort + fpsShort) * 10;
+	return cost;
+}
+
+int selectCameraFormat(const QVector<agora::rtc::VideoFormat>& formats, int width, int height, int fps)
+{
+	int best = -1;
+	int bestCost = INT_MAX;
+	for (int i = 0; i < formats.size(); ++i) {
+		int cost = cameraFormatCost(formats[i], width, height, fps);
+		if (best < 0 || cost < bestCost) {
+			best = i;
+			bestCost = cost;
+		}
+	}
+	return best;
+}
+
+QVector<agora::rtc::VideoFormat> cameraFormatMatrix(const QVector<agora::rtc::VideoFormat>& formats)
+{
+	QVector<agora::rtc::VideoFormat> matrix;
+	for (const agora::rtc::VideoFormat& format : formats) {
+		bool known = false;
+		for (const agora::rtc::VideoFormat& other : matrix) {
+			if (other.width == format.width && other.height == format.height && other.fps == format.fps) {
+				known = true;
+				break;
+			}
+		}
+		if (!known)
+			matrix.push_back(format);
+	}
+	std::sort(matrix.begin(), matrix.end(),
+		[](const agora::rtc::VideoFormat& a, const agora::rtc::VideoFormat& b) {
+		long long areaA = (long long)a.width * a.height;
+		long long areaB = (long long)b.width * b.height;
+		if (areaA != areaB)
+			return areaA < areaB;
+		if (a.width != b.width)
+			return a.width < b.width;
+		return a.fps < b.fps;
+	});
+	return matrix;
+}
@@ -0,0 +1,24 @@
+#ifndef CAMERAFORMATS_H
+#define CAMERAFORMATS_H
+
+#include <AgoraBase.h>
+
+#include <QVector>
+
+//cost of a capture format that already is the encoder target
+#define CAMERA_FORMAT_EXACT 0
+//costs from here on need upscaling or frame duplication
+#define CAMERA_FORMAT_SHORT 100000
+
+// Capture format selection for a camera.
+// The cost of a capture format is the conversion work between it and the
+// encoder target: nothing for an exact match, dropping frames for a higher
+// frame rate, scaling down and cropping for a larger size. Formats smaller
+// or slower than the target are only used when nothing covers it.
+int cameraFormatCost(const agora::rtc::VideoFormat& format, int width, int height, int fps);
+//index of the cheapest format, -1 when formats is empty
+int selectCameraFormat(const QVector<agora::rtc::VideoFormat>& formats, int width, int height, int fps);
+//distinct formats sorted by size, then frame rate
+QVector<agora::rtc::VideoFormat> cameraFormatMatrix(const QVector<agora::rtc::VideoFormat>& formats);
+
+#endif // CAMERAFORMATS_H
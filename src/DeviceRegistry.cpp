@@ -0,0 +1,161 @@
+#include "DeviceRegistry.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+DeviceRegistry::~DeviceRegistry()
+{
+	Stop();
+}
+
+void DeviceRegistry::Start(agora::rtc::IRtcEngine* engine)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (running_ || engine == nullptr)
+		return;
+	engine_ = engine;
+	running_ = true;
+	pending_ = (1u << DEVICE_KIND_COUNT) - 1;
+	thread_ = std::thread(&DeviceRegistry::Run, this);
+}
+
+void DeviceRegistry::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		running_ = false;
+		pending_ = 0;
+	}
+	cond_.notify_all();
+	if (thread_.joinable())
+		thread_.join();
+}
+
+void DeviceRegistry::RequestRefresh(DEVICE_KIND kind)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!running_)
+			return;
+		pending_ |= 1u << kind;
+	}
+	cond_.notify_all();
+}
+
+int DeviceRegistry::Count(DEVICE_KIND kind)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return devices_[kind].size();
+}
+
+bool DeviceRegistry::Device(DEVICE_KIND kind, int index, QString& name, QString& id)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (index < 0 || index >= devices_[kind].size())
+		return false;
+	name = devices_[kind][index].name;
+	id = devices_[kind][index].id;
+	return true;
+}
+
+QVector<agora::rtc::VideoFormat> DeviceRegistry::Formats(const QString& cameraId)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (const CachedDevice& device : devices_[DEVICE_CAMERA]) {
+		if (device.id == cameraId)
+			return device.formats;
+	}
+	return QVector<agora::rtc::VideoFormat>();
+}
+
+void DeviceRegistry::Run()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (running_) {
+		cond_.wait(lock, [this]() { return pending_ != 0 || !running_; });
+		while (running_ && pending_ != 0) {
+			int kind = 0;
+			while (!(pending_ & (1u << kind)))
+				++kind;
+			pending_ &= ~(1u << kind);
+			lock.unlock();
+			QElapsedTimer timer;
+			timer.start();
+			QVector<CachedDevice> devices = Enumerate((DEVICE_KIND)kind);
+			qDebug() << "device registry kind" << kind << devices.size() << "devices," << timer.elapsed() << "ms";
+			lock.lock();
+			devices_[kind] = devices;
+			if (changed_) {
+				lock.unlock();
+				changed_((DEVICE_KIND)kind);
+				lock.lock();
+			}
+		}
+	}
+}
+
+//runs on the worker without the lock
+QVector<CachedDevice> DeviceRegistry::Enumerate(DEVICE_KIND kind)
+{
+	QVector<CachedDevice> devices;
+	char name[agora::rtc::MAX_DEVICE_ID_LENGTH] = { 0 };
+	char id[agora::rtc::MAX_DEVICE_ID_LENGTH] = { 0 };
+	if (kind == DEVICE_MIC || kind == DEVICE_SPEAKER) {
+		agora::rtc::AAudioDeviceManager manager(engine_);
+		if (manager.get() == nullptr)
+			return devices;
+		agora::rtc::IAudioDeviceCollection* collection = kind == DEVICE_MIC ?
+			manager->enumerateRecordingDevices() : manager->enumeratePlaybackDevices();
+		if (collection == nullptr)
+			return devices;
+		int count = collection->getCount();
+		for (int i = 0; i < count; ++i) {
+			if (collection->getDevice(i, name, id) != 0)
+				continue;
+			CachedDevice device;
+			device.name = QString::fromUtf8(name);
+			device.id = QString::fromUtf8(id);
+			devices.push_back(device);
+		}
+		collection->release();
+		return devices;
+	}
+
+	agora::rtc::AVideoDeviceManager manager(engine_);
+	if (manager.get() == nullptr)
+		return devices;
+	agora::rtc::IVideoDeviceCollection* collection = manager->enumerateVideoDevices();
+	if (collection == nullptr)
+		return devices;
+	QVector<CachedDevice> known;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		known = devices_[DEVICE_CAMERA];
+	}
+	int count = collection->getCount();
+	for (int i = 0; i < count; ++i) {
+		if (collection->getDevice(i, name, id) != 0)
+			continue;
+		CachedDevice device;
+		device.name = QString::fromUtf8(name);
+		device.id = QString::fromUtf8(id);
+		for (const CachedDevice& old : known) {
+			if (old.id == device.id) {
+				device.formats = old.formats;
+				break;
+			}
+		}
+		//the capability query opens the driver, it is the slow part
+		if (device.formats.isEmpty()) {
+			int formats = manager->numberOfCapabilities(id);
+			for (int j = 0; j < formats; ++j) {
+				agora::rtc::VideoFormat format;
+				if (manager->getCapability(id, j, format) == 0)
+					device.formats.push_back(format);
+			}
+		}
+		devices.push_back(device);
+	}
+	collection->release();
+	return devices;
+}
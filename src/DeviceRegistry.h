@@ -0,0 +1,67 @@
+#ifndef DEVICEREGISTRY_H
+#define DEVICEREGISTRY_H
+
+#include <IAgoraRtcEngine.h>
+
+#include <QString>
+#include <QVector>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+enum DEVICE_KIND
+{
+	DEVICE_MIC = 0,
+	DEVICE_SPEAKER,
+	DEVICE_CAMERA,
+	DEVICE_KIND_COUNT
+};
+
+typedef struct tagCachedDevice
+{
+	QString name;
+	QString id;
+	//capture formats as reported by the driver, cameras only
+	QVector<agora::rtc::VideoFormat> formats;
+}CachedDevice;
+
+// Microphones, speakers and cameras of the machine, enumerated once on a
+// worker thread after the engine is initialized and kept in memory, so the
+// settings dialogs never wait for the drivers: they show what is known and
+// fill their lists on each changed call. A device state callback
+// enumerates its kind again; camera formats are only queried for ids that
+// were not known before. Readers take a copy under the lock.
+class DeviceRegistry
+{
+public:
+	typedef std::function<void(DEVICE_KIND kind)> ChangedFunc;
+	~DeviceRegistry();
+	//starts the worker with a full enumeration
+	void Start(agora::rtc::IRtcEngine* engine);
+	void Stop();
+	//called on the worker after each enumeration
+	void SetChangedFunc(ChangedFunc changed) { changed_ = changed; }
+	//enumerate kind again, safe on the sdk callback thread
+	void RequestRefresh(DEVICE_KIND kind);
+
+	int Count(DEVICE_KIND kind);
+	bool Device(DEVICE_KIND kind, int index, QString& name, QString& id);
+	//empty for unknown ids
+	QVector<agora::rtc::VideoFormat> Formats(const QString& cameraId);
+private:
+	void Run();
+	QVector<CachedDevice> Enumerate(DEVICE_KIND kind);
+
+	agora::rtc::IRtcEngine* engine_ = nullptr;
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	bool running_ = false;
+	//bit per DEVICE_KIND waiting for the worker
+	unsigned int pending_ = 0;
+	QVector<CachedDevice> devices_[DEVICE_KIND_COUNT];
+	ChangedFunc changed_;
+};
+
+#endif // DEVICEREGISTRY_H
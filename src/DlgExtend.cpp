@@ -63,6 +63,7 @@ void DlgExtend::on_closeButton_clicked()
 		}
 		rtcEngine->VideoSourceLeave(setting.className.toUtf8(), setting.userInfo.uid);
 		rtcEngine->SetJoined(false);
+		rtcEngine->LeaveExtraVideoSources();
 	
 		CloseDlg();
 		emit closeRoom(true);
@@ -75,8 +76,9 @@ void DlgExtend::CloseDlg()
 {
 	ResetWidgets();
 	widgetInfos_.clear();
-	videoWidget[2]->hide();
-	videoWidget[3]->hide();
+	//both tiles stay in the row, only their frame planes are given back
+	for (int i = 0; i < widgetsCount; ++i)
+		videoWidget[i]->ReleaseFrameBuffers();
 	hide();
 	rtcEngine->ResetVideoWidgets();
 }
@@ -124,11 +126,7 @@ void DlgExtend::on_settingDlg_close()
 	if (setting.enabledVideoSource2) {
 		if (!rtcEngine->IsJoined2()) {
 			rtcEngine->SetJoined2(true);
-			bool subscribe = !rtcEngine->IsvideoSource1Subscribe();
-			rtcEngine->VideoSource2JoinChannel(setting.enabledVideoSource2, "", setting.className.toUtf8(), setting.userInfo2.uid, subscribe, subscribe);
-		}
-		else if (!rtcEngine->IsJoined() && rtcEngine->IsvideoSource1Subscribe()) {//
-			rtcEngine->UpdateVideoSource2Subscribe(true);
+			rtcEngine->VideoSource2JoinChannel(setting.enabledVideoSource2, "", setting.className.toUtf8(), setting.userInfo2.uid);
 		}
 	}
 	else if (!setting.enabledVideoSource2
@@ -136,6 +134,10 @@ void DlgExtend::on_settingDlg_close()
 		rtcEngine->SetJoined2(false);
 		rtcEngine->VideoSourceLeave(setting.className.toUtf8(), setting.userInfo2.uid);
 	}
+
+	//document camera and screen share
+	rtcEngine->SyncVideoSource(VIDEO_SOURCE_CAMERA_SECONDARY, setting.enabledVideoSource3, setting.className, setting.userInfo3.uid);
+	rtcEngine->SyncVideoSource(VIDEO_SOURCE_SCREEN, setting.enabledScreenShare, setting.className, setting.userInfo4.uid);
 }
 
 bool DlgExtend::IsUpdateVideoSource()
@@ -207,10 +209,14 @@ void DlgExtend::showEvent(QShowEvent *event)
 	}
 	if (setting.enabledVideoSource2) {
 		connect(AgoraRtcEngine::GetAgoraRtcEngine(), &AgoraRtcEngine::openPlayerComplete,
-			this, &DlgExtend::on_openPlayerComplete);
+			this, &DlgExtend::on_openPlayerComplete, Qt::UniqueConnection);
 		connect(AgoraRtcEngine::GetAgoraRtcEngine(), &AgoraRtcEngine::playerError,
-			this, &DlgExtend::on_playerError);
-		rtcEngine->OpenVideoSource2(setting.videoSource2Url);
+			this, &DlgExtend::on_playerError, Qt::UniqueConnection);
+		//usually open and playing since the login
+		if (rtcEngine->Player()->IsOpened())
+			on_openPlayerComplete();
+		else
+			rtcEngine->Player()->Open(setting.videoSource2Url, true);
 	}
 	QRoundCornerDialog::showEvent(event);
 }
@@ -225,6 +231,12 @@ void DlgExtend::keyPressEvent(QKeyEvent* event)
 	if (event->key() == VK_RETURN) {
 		return;
 	}
+	//F3-F5 debug switches of the video tiles
+	if (VideoWidget::HandleDebugKey(event->key())) {
+		for (int i = 0; i < widgetsCount; ++i)
+			videoWidget[i]->update();
+		return;
+	}
 
 	QDialog::keyPressEvent(event);
 }
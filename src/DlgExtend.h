@@ -6,6 +6,7 @@
 #include "QRoundCornerDialog.h"
 #include <QVector>
 #include "SettingsData.h"
+#include "LayoutEngine.h"
 #include <unordered_set>
 #include "DlgSettings.h"
 #define VIDEO_COUNT 4
@@ -32,28 +33,13 @@ private:
 	DlgSettings* dlgSettings = nullptr;
 	DlgVideoRoom* dlgRoom = nullptr;
 	bool bMax = true;
-	//title
-	int titleHeight = 67;
-	int titleFontSize = 48;
-	int titleTopMargin = 48;
-	int titleBottomMargin = 20;
-	int labTitleW = 192;
-	int labTitleH = 67;
-
 	//video widget
 	int videoW = 710;
 	int videoH = 400;
-	int videoSpace = 36;
-	int videoMargin = 73;
-	int pageBtnW = 52;
-	int pageBtnH = 52;
-	int midMargin = 98;
-	int bottomTopMargin = 18;
-	
-	void setTopButtonLayout();
-	void setTitleLayout();
-	void setOptionLayout();
-	void setBottomLabel();
+	LayoutEngine layout_;
+
+	void BuildLayoutSpec();
+	void ApplyLayout();
 	void InitDlg();
 	void ShowTopAndBottom(bool bShow);
 	void UpdateLayout();
@@ -13,6 +13,8 @@ DlgSettingAudio::DlgSettingAudio(float initRate, float rate, float rate2, QWidge
 	this->rate = rate;
 	InitDlg();
 	UpdateCtrls();
+	connect(rtcEngine, &AgoraRtcEngine::devicesChanged,
+		this, &DlgSettingAudio::onDevicesChanged);
 	agoraCourse = course;
 }
 
@@ -59,6 +61,13 @@ void DlgSettingAudio::UpdateCtrls()
 	}
 }
 
+//a microphone or speaker was plugged in or removed while the dialog is open
+void DlgSettingAudio::onDevicesChanged(int kind)
+{
+	if (kind == DEVICE_MIC || kind == DEVICE_SPEAKER)
+		UpdateCtrls();
+}
+
 void DlgSettingAudio::on_closeButton_clicked()
 {
 	onExit();
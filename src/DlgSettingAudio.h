@@ -103,6 +103,7 @@ private slots:
 	void on_btnANSStatsPre_clicked();
 	void on_btnANSStatsNext_clicked();
 	void on_parentMax_slot(bool childMax);
+	void onDevicesChanged(int kind);
 public slots:
 	void on_maxButton_clicked();
 public:
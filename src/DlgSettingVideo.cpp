@@ -6,6 +6,51 @@
 #include "DlgInfo.h"
 #include "DlgSettings.h"
 #include "DlgSettings.h"
+#include "EncoderBackend.h"
+#include "VideoGrid.h"
+#include <algorithm>
+
+static QString encoderTypeText(int type)
+{
+	switch (type) {
+	case ENCODER_SOFTWARE:
+		return QString::fromStdWString(L"软件");
+	case ENCODER_NVIDIA:
+		return QString("NVIDIA");
+	case ENCODER_INTEL:
+		return QString("Intel");
+	default:
+		return QString::fromStdWString(L"自动");
+	}
+}
+
+//default, software and the vendors of the gpus present
+static int stepEncoderType(int type, int step)
+{
+	for (int next = type + step; next >= ENCODER_DEFAULT && next <= ENCODER_INTEL; next += step) {
+		if (next <= ENCODER_SOFTWARE || encoderTypeAvailable(next))
+			return next;
+	}
+	return type;
+}
+
+//BT.601, BT.709 limited, then full range; limited is what cameras send unless told otherwise
+#define COLOR_PRESET_COUNT 4
+
+static VideoColorInfo colorPreset(int index)
+{
+	VideoColorInfo color;
+	color.matrix = index % 2 ? VIDEO_COLOR_BT709 : VIDEO_COLOR_BT601;
+	color.fullRange = index >= 2;
+	return color;
+}
+
+static QString colorInfoText(const VideoColorInfo& color)
+{
+	QString text = color.matrix == VIDEO_COLOR_BT709 ? QString("BT.709") : QString("BT.601");
+	return text + (color.fullRange ? QString::fromStdWString(L" 全范围") : QString::fromStdWString(L" 有限范围"));
+}
+
 DlgSettingVideo::DlgSettingVideo(float initRate, float rate, float rate2, QWidget* course, QWidget *parent, bool bSecond)
 	: QRoundCornerDialog(parent)
 {
@@ -14,6 +59,48 @@ DlgSettingVideo::DlgSettingVideo(float initRate, float rate, float rate2, QWidge
 	this->initRate = initRate;
 	this->rate2 = rate2;
 	this->rate = rate;
+	//camera preview is drawn from the capture frames
+	previewWidget_ = new VideoWidget(initRate, rate, ui.widgetVideo1);
+	previewWidget_->SetPreview(true);
+	encoderRow_ = new SettingOptionRow(QString::fromStdWString(L"编码器"), ui.verticalLayout_video2Setting, this);
+	connect(encoderRow_, &SettingOptionRow::previous, this, [this]() {
+		SetEncoderType(stepEncoderType(setting.encoder_type, -1));
+	});
+	connect(encoderRow_, &SettingOptionRow::next, this, [this]() {
+		SetEncoderType(stepEncoderType(setting.encoder_type, 1));
+	});
+	adaptiveRow_ = new SettingOptionRow(QString::fromStdWString(L"自适应"), ui.verticalLayout_video2Setting, this);
+	connect(adaptiveRow_, &SettingOptionRow::previous, this, [this]() { SetAdaptiveEncoder(false); });
+	connect(adaptiveRow_, &SettingOptionRow::next, this, [this]() { SetAdaptiveEncoder(true); });
+	SetAdaptiveEncoder(setting.adaptiveEncoder);
+	documentCameraRow_ = new SettingOptionRow(QString::fromStdWString(L"文档相机"), ui.verticalLayout_video2Setting, this);
+	connect(documentCameraRow_, &SettingOptionRow::previous, this, [this]() { StepDocumentCamera(-1); });
+	connect(documentCameraRow_, &SettingOptionRow::next, this, [this]() { StepDocumentCamera(1); });
+	screenShareRow_ = new SettingOptionRow(QString::fromStdWString(L"屏幕共享"), ui.verticalLayout_video2Setting, this);
+	connect(screenShareRow_, &SettingOptionRow::previous, this, [this]() { SetScreenShare(false); });
+	connect(screenShareRow_, &SettingOptionRow::next, this, [this]() { SetScreenShare(true); });
+	SetScreenShare(setting.enabledScreenShare);
+	studentTypeRow_ = new SettingOptionRow(QString::fromStdWString(L"班型"), ui.verticalLayout_video2Setting, this);
+	connect(studentTypeRow_, &SettingOptionRow::previous, this, [this]() { StepStudentType(-1); });
+	connect(studentTypeRow_, &SettingOptionRow::next, this, [this]() { StepStudentType(1); });
+	StepStudentType(0);
+	snapshotRow_ = new SettingOptionRow(QString::fromStdWString(L"监控快照"), ui.verticalLayout_video2Setting, this);
+	connect(snapshotRow_, &SettingOptionRow::previous, this, [this]() { SetSnapshotMonitor(false); });
+	connect(snapshotRow_, &SettingOptionRow::next, this, [this]() { SetSnapshotMonitor(true); });
+	SetSnapshotMonitor(setting.snapshotMonitor);
+	recordingRow_ = new SettingOptionRow(QString::fromStdWString(L"本地录制"), ui.verticalLayout_video2Setting, this);
+	connect(recordingRow_, &SettingOptionRow::previous, this, [this]() { SetRecording(false); });
+	connect(recordingRow_, &SettingOptionRow::next, this, [this]() { SetRecording(true); });
+	recordingRow_->SetToolTip(QString::fromStdWString(L"本地视频写入程序目录下的 recordings，快捷键 F6"));
+	UpdateRecordingRow();
+	cameraColorRow_ = new SettingOptionRow(QString::fromStdWString(L"相机色彩"), ui.verticalLayout_video2Setting, this);
+	connect(cameraColorRow_, &SettingOptionRow::previous, this, [this]() { StepColorInfo(VIDEO_SOURCE_CAMERA_PRIMARY, -1); });
+	connect(cameraColorRow_, &SettingOptionRow::next, this, [this]() { StepColorInfo(VIDEO_SOURCE_CAMERA_PRIMARY, 1); });
+	StepColorInfo(VIDEO_SOURCE_CAMERA_PRIMARY, 0);
+	documentColorRow_ = new SettingOptionRow(QString::fromStdWString(L"文档色彩"), ui.verticalLayout_video2Setting, this);
+	connect(documentColorRow_, &SettingOptionRow::previous, this, [this]() { StepColorInfo(VIDEO_SOURCE_CAMERA_SECONDARY, -1); });
+	connect(documentColorRow_, &SettingOptionRow::next, this, [this]() { StepColorInfo(VIDEO_SOURCE_CAMERA_SECONDARY, 1); });
+	StepColorInfo(VIDEO_SOURCE_CAMERA_SECONDARY, 0);
 	
 	UpdateVideoDeviceInfo();
 
@@ -21,6 +108,13 @@ DlgSettingVideo::DlgSettingVideo(float initRate, float rate, float rate2, QWidge
 	
 	SetVideoEncoder();
 	UpdateCtrls();
+	UpdateEncoderRow();
+	connect(rtcEngine, &AgoraRtcEngine::devicesChanged,
+		this, &DlgSettingVideo::onDevicesChanged);
+	connect(rtcEngine, &AgoraRtcEngine::encoderChanged,
+		this, &DlgSettingVideo::onEncoderChanged);
+	connect(rtcEngine, &AgoraRtcEngine::recordingChanged,
+		this, &DlgSettingVideo::onRecordingChanged);
 	//rtcEngine->GetEngine()
 	//int getCapability(const char* deviceIdUTF8, const uint32_t deviceCapabilityNumber, VideoFormat & capability)
 	if (setting.enabledVideoSource2 && rtcEngine->IsJoined2() ) {
@@ -37,13 +131,15 @@ DlgSettingVideo::DlgSettingVideo(float initRate, float rate, float rate2, QWidge
 
 DlgSettingVideo::~DlgSettingVideo()
 {
+	//the capture callback must not reach previewWidget_ any more
+	rtcEngine->LocalVideoPreview(previewWidget_, false);
 }
 
 void DlgSettingVideo::onCancel()
 {
 	if (setting.enabledVideoSource1) {
 		SetVideoEncoder();
-		rtcEngine->LocalVideoPreview((HWND)ui.widgetVideo1->winId(), false);
+		rtcEngine->LocalVideoPreview(previewWidget_, false);
 	}
 	if (setting.enabledVideoSource2) {
 		if (!rtcEngine->IsJoined() && !rtcEngine->IsJoined2())
@@ -56,7 +152,15 @@ void DlgSettingVideo::onCancel()
 void DlgSettingVideo::UpdateCtrls()
 {
 	// video
+	UpdateVideoDeviceList();
+	if (!videoInfos_.isEmpty() && setting.enabledVideoSource1)
+		rtcEngine->LocalVideoPreview(previewWidget_, true);
+}
+
+void DlgSettingVideo::UpdateVideoDeviceList()
+{
 	videoInfos_.clear();
+	videoDeviceIds_.clear();
 	int count = rtcEngine->GetVideoDeviceCount();
 	if (count > 0) {
 		QString curId = rtcEngine->GetCurVideoDeviceID();
@@ -64,17 +168,161 @@ void DlgSettingVideo::UpdateCtrls()
 			DeviceInfo info;
 			rtcEngine->GetVideoDevice(i, info.name, info.id);
 			videoInfos_.insert(info.id, info.name);
+			videoDeviceIds_.append(info.id);
 		}
 
 		if (setting.videoSource1Id.isEmpty()) {
 			setting.videoSource1Id = curId;
 		}
-		QString name = videoInfos_[setting.videoSource1Id];
 		ui.btnVideoSource1->setText(videoInfos_[setting.videoSource1Id]);
+	}
+	UpdateDocumentCameraRow();
+}
+
+//a camera was plugged in or removed while the dialog is open
+void DlgSettingVideo::onDevicesChanged(int kind)
+{
+	if (kind != DEVICE_CAMERA)
+		return;
+	UpdateVideoDeviceList();
+	UpdateVideoDeviceInfo();
+}
+
+void DlgSettingVideo::SetEncoderType(int type)
+{
+	if (type == setting.encoder_type)
+		return;
+	setting.encoder_type = type;
+	//a running camera switches at once, otherwise the next join applies it
+	if (rtcEngine->IsJoined() && type != ENCODER_DEFAULT)
+		rtcEngine->SetEncoderType(type);
+	UpdateEncoderRow();
+}
+
+void DlgSettingVideo::UpdateEncoderRow()
+{
+	EncoderReport report = rtcEngine->GetEncoderReport();
+	QString text = encoderTypeText(setting.encoder_type);
+	QString tip;
+	if (setting.encoder_type != ENCODER_DEFAULT && report.requested == setting.encoder_type && report.fellBack) {
+		text = encoderTypeText(report.active);
+		tip = QString::fromStdWString(L"%1编码不可用，已切换到软件编码").arg(encoderTypeText(report.requested));
+	}
+	encoderRow_->SetValue(text);
+	encoderRow_->SetToolTip(tip);
+}
+
+//steps the camera encoder down under cpu or uplink pressure
+void DlgSettingVideo::SetAdaptiveEncoder(bool enabled)
+{
+	if (enabled != setting.adaptiveEncoder) {
+		setting.adaptiveEncoder = enabled;
+		rtcEngine->Encoder()->SetEnabled(enabled);
+	}
+	adaptiveRow_->SetValue(enabled ? QString::fromStdWString(L"开启") : QString::fromStdWString(L"关闭"));
+}
 
-		if (setting.enabledVideoSource1)
-			rtcEngine->LocalVideoPreview((HWND)ui.widgetVideo1->winId(), true);
+void DlgSettingVideo::SetSnapshotMonitor(bool enabled)
+{
+	if (enabled != setting.snapshotMonitor) {
+		setting.snapshotMonitor = enabled;
+		rtcEngine->SetSnapshotMonitor(enabled);
 	}
+	snapshotRow_->SetValue(enabled ? QString::fromStdWString(L"开启") : QString::fromStdWString(L"关闭"));
+}
+
+//Y4M recording of the local sources, the same as F6 in the room
+void DlgSettingVideo::SetRecording(bool enabled)
+{
+	if (rtcEngine->IsRecording() && rtcEngine->RecordingFormat() != RECORD_FORMAT_Y4M)
+		return;
+	if (!rtcEngine->SetRecording(RECORD_FORMAT_Y4M, enabled)) {
+		QString strInfo = QString::fromStdWString(L"本地录制启动失败");
+		DlgInfo dlg(strInfo, rate, rate2, initRate, bSecond);
+		connect(&dlg, &DlgInfo::parentMaxSignal,
+			this, &DlgSettingVideo::on_parentMax_slot);
+		if (!bMax && dlg.IsMax())
+			dlg.maxButtonChange(true);
+		dlg.exec();
+	}
+	UpdateRecordingRow();
+}
+
+//a replay capture of F7 keeps the row until it is stopped with F7
+void DlgSettingVideo::UpdateRecordingRow()
+{
+	if (!rtcEngine->IsRecording())
+		recordingRow_->SetValue(QString::fromStdWString(L"关闭"));
+	else if (rtcEngine->RecordingFormat() == RECORD_FORMAT_Y4M)
+		recordingRow_->SetValue(QString::fromStdWString(L"开启"));
+	else
+		recordingRow_->SetValue(QString::fromStdWString(L"回放采集中"));
+}
+
+void DlgSettingVideo::onRecordingChanged(bool recording, bool failed)
+{
+	Q_UNUSED(recording);
+	Q_UNUSED(failed);
+	UpdateRecordingRow();
+}
+
+//the capture frames carry no color space, a camera that sends BT.709 or full range is set here
+void DlgSettingVideo::StepColorInfo(VIDEO_SOURCE_KIND kind, int step)
+{
+	bool document = kind == VIDEO_SOURCE_CAMERA_SECONDARY;
+	VideoColorInfo& color = document ? setting.videoSource3Color : setting.videoSource1Color;
+	int index = (color.matrix == VIDEO_COLOR_BT709 ? 1 : 0) + (color.fullRange ? 2 : 0);
+	color = colorPreset((std::min)((std::max)(index + step, 0), COLOR_PRESET_COUNT - 1));
+	rtcEngine->SetSourceColorInfo(kind, color);
+	(document ? documentColorRow_ : cameraColorRow_)->SetValue(colorInfoText(color));
+}
+
+//applied to the room grid when the settings close
+void DlgSettingVideo::StepStudentType(int step)
+{
+	int type = (std::min)((std::max)((int)setting.studentType + step, (int)STUDENT_1V1), (int)STUDENT_1V16);
+	setting.studentType = (STUDENT_1VN_TYPE)type;
+	studentTypeRow_->SetValue(QString(videoGridName(setting.studentType)));
+}
+
+void DlgSettingVideo::StepDocumentCamera(int step)
+{
+	QStringList ids;
+	for (const QString& id : videoDeviceIds_) {
+		if (id != setting.videoSource1Id)
+			ids.append(id);
+	}
+	//index 0 is off
+	int index = setting.enabledVideoSource3 ? ids.indexOf(setting.videoSource3Id) + 1 : 0;
+	index = (std::max)(0, (std::min)(index + step, (int)ids.size()));
+	setting.enabledVideoSource3 = index > 0;
+	if (index > 0)
+		setting.videoSource3Id = ids[index - 1];
+	UpdateDocumentCameraRow();
+}
+
+void DlgSettingVideo::UpdateDocumentCameraRow()
+{
+	//the camera was unplugged or became the teacher camera
+	if (setting.enabledVideoSource3 && (!videoInfos_.contains(setting.videoSource3Id)
+		|| setting.videoSource3Id == setting.videoSource1Id))
+		setting.enabledVideoSource3 = false;
+	QString name = setting.enabledVideoSource3 ? videoInfos_[setting.videoSource3Id] : QString::fromStdWString(L"关闭");
+	documentCameraRow_->SetValue(name);
+	documentCameraRow_->SetToolTip(name);
+}
+
+void DlgSettingVideo::SetScreenShare(bool enabled)
+{
+	setting.enabledScreenShare = enabled;
+	screenShareRow_->SetValue(enabled ? QString::fromStdWString(L"开启") : QString::fromStdWString(L"关闭"));
+}
+
+//the camera session fell back to software while the dialog is open
+void DlgSettingVideo::onEncoderChanged(int type)
+{
+	Q_UNUSED(type);
+	UpdateEncoderRow();
 }
 
 void DlgSettingVideo::UpdateVideoDeviceInfo()
@@ -106,7 +354,6 @@ void DlgSettingVideo::UpdateVideoDeviceInfo()
 			setting.resIndex = 0;
 	}
 	SetResolution();
-	QString strFPS = QString("%1").arg(videoDeviceInfos_[0].fps);
 	ui.labVideo1FPSInfo->setText(fpsInfos_[QString("%1").arg(setting.frameRate)]);
 }
 
@@ -120,6 +367,7 @@ void DlgSettingVideo::on_btnVideoSource1_clicked()
 	dlg.exec();
 	UpdateVideoDeviceInfo();
 	ui.btnVideoSource1->setText(videoInfos_[setting.videoSource1Id]);
+	UpdateDocumentCameraRow();
 }
 
 void DlgSettingVideo::SetResolution()
@@ -140,9 +388,10 @@ void DlgSettingVideo::on_btnVideo1StatsPre_clicked() {
 	ui.labVideo1Stat->setText(QString::fromStdWString(L"关闭"));
 	ui.labVideo1Stats->setText(QString::fromStdWString(L"关闭"));
 	setting.enabledVideoSource1 = false;
-	rtcEngine->LocalVideoPreview(NULL, false);
+	rtcEngine->LocalVideoPreview(previewWidget_, false);
 	rtcEngine->EnableLocalVideo(false);
-	ui.widgetVideo1->update();
+	previewWidget_->Reset();
+	previewWidget_->update();
 	
 }
 void DlgSettingVideo::on_btnVideo1StatsNext_clicked()
@@ -153,7 +402,7 @@ void DlgSettingVideo::on_btnVideo1StatsNext_clicked()
 	ui.labVideo1Stats->setText(QString::fromStdWString(L"开启"));
 	setting.enabledVideoSource1 = true;
 	rtcEngine->EnableLocalVideo(true);
-	rtcEngine->LocalVideoPreview((HWND)ui.widgetVideo1->winId(), true);
+	rtcEngine->LocalVideoPreview(previewWidget_, true);
 }
 
 void DlgSettingVideo::on_btnvideo2StatsPre_clicked() 
@@ -4,6 +4,9 @@
 #include<QDialog>
 #include "ui_DlgSettingVideo.h"
 #include "QRoundCornerDialog.h"
+#include "VideoWidget.h"
+#include "SettingOptionRow.h"
+#include "VideoSource.h"
 #include <QMap>
 #include <QHash>
 #include <QSet>
@@ -19,6 +22,16 @@ public:
 private:
 	Ui::DlgSettingVideo ui;
 	QWidget* agoraCourse = nullptr;
+	VideoWidget* previewWidget_ = nullptr;
+	SettingOptionRow* encoderRow_ = nullptr;
+	SettingOptionRow* adaptiveRow_ = nullptr;
+	SettingOptionRow* documentCameraRow_ = nullptr;
+	SettingOptionRow* screenShareRow_ = nullptr;
+	SettingOptionRow* studentTypeRow_ = nullptr;
+	SettingOptionRow* snapshotRow_ = nullptr;
+	SettingOptionRow* recordingRow_ = nullptr;
+	SettingOptionRow* cameraColorRow_ = nullptr;
+	SettingOptionRow* documentColorRow_ = nullptr;
 	bool bSecond = false;
 	bool bMax = true;
 	//title
@@ -79,6 +92,8 @@ private:
 	void setVideoSourceLayout();
 	void setBottomLabel();
 	void setEditStyle(bool bEnable);
+	//sizes of the rows built in code, same as the .ui rows
+	SettingRowMetrics RowMetrics();
 	void SetResolution();
 	void SetEnabledVideoSource1();
 	void SetEnabledVideoSource2();
@@ -86,11 +101,30 @@ private:
 	int fps[4];
 	std::map<int, std::pair<int, int> > m_mapResolution;
 	QHash<QString, QString> videoInfos_;
+	//camera ids in device order, videoInfos_ has no order
+	QStringList videoDeviceIds_;
 	QMap<QString, QString> fpsInfos_;
 	QMap<QString, QString> resolutionInfos_;
 	QVector<agora::rtc::VideoFormat> videoDeviceInfos_;
 	void InitData();
 	void UpdateCtrls();
+	//videoInfos_ and the camera button from the device registry
+	void UpdateVideoDeviceList();
+	void SetEncoderType(int type);
+	//the chosen encoder, or the software one it fell back to
+	void UpdateEncoderRow();
+	void SetAdaptiveEncoder(bool enabled);
+	//off, then every camera but the teacher camera; joined when the settings close
+	void StepDocumentCamera(int step);
+	void UpdateDocumentCameraRow();
+	void SetScreenShare(bool enabled);
+	//1vN grid of the room, pages of videoGridCapacity tiles
+	void StepStudentType(int step);
+	void SetSnapshotMonitor(bool enabled);
+	void SetRecording(bool enabled);
+	void UpdateRecordingRow();
+	//cycles BT.601/BT.709 limited, then full range, applied at once
+	void StepColorInfo(VIDEO_SOURCE_KIND kind, int step);
 private:
 	void onCancel();
 	void SetVideoEncoder();
@@ -111,6 +145,9 @@ private slots:
 	void on_openPlayerComplete();
 	void on_parentMax_slot(bool childMax);
 	void on_playerError(int ec);
+	void onDevicesChanged(int kind);
+	void onEncoderChanged(int type);
+	void onRecordingChanged(bool recording, bool failed);
 public slots:
 	void on_maxButton_clicked();
 public:
@@ -10,12 +10,18 @@
 #include "agoracourse.h"
 #include "DlgSettings.h"
 #include "DlgExtend.h"
+#include <QEvent>
+#include <algorithm>
 DlgVideoRoom::DlgVideoRoom(QWidget* parent)
 	: QRoundCornerDialog(parent)
 {
 	ui.setupUi(this);
 	InitDlg();
 	agoraCourse = parent;
+	titleText_ = ui.labTitle->text();
+	connect(rtcEngine, &AgoraRtcEngine::recordingChanged,
+		this, &DlgVideoRoom::onRecordingChanged);
+	onRecordingChanged(rtcEngine->IsRecording(), false);
 }
 void DlgVideoRoom::SetRate(float rate, float rate2)
 {
@@ -28,11 +34,14 @@ DlgVideoRoom::~DlgVideoRoom()
 		this, &DlgVideoRoom::on_openPlayerComplete);
 	disconnect(AgoraRtcEngine::GetAgoraRtcEngine(), &AgoraRtcEngine::playerError,
 		this, &DlgVideoRoom::on_playerError);
+	disconnect(AgoraRtcEngine::GetAgoraRtcEngine(), &AgoraRtcEngine::recordingChanged,
+		this, &DlgVideoRoom::onRecordingChanged);
 }
 
 void DlgVideoRoom::UpdateShowVideos()
 {
-	if (widgetInfos_.size() > 4)
+	UpdateCapacity();
+	if (widgetInfos_.size() > widgetsCount)
 		showPage(true);
 	else
 		showPage(false);
@@ -40,37 +49,92 @@ void DlgVideoRoom::UpdateShowVideos()
 	int firstIndex = curPage * widgetsCount;
 	
 	for (int i = firstIndex; i < widgetInfos_.size() && i < (firstIndex + widgetsCount); ++i) {
-		int index = i % widgetsCount;
+		VideoWidget* tile = tiles_.Tile(i % widgetsCount);
 		if (widgetInfos_[i].userInfo.uid == setting.userInfo2.uid)
 			rtcEngine->PauseVideoSource2(false);
-		videoWidget[index]->SetWidgetInfo(widgetInfos_[i]);
-		map.insert(widgetInfos_[i].userInfo.uid, videoWidget[index]);
+		tile->SetWidgetInfo(widgetInfos_[i]);
+		map.insert(widgetInfos_[i].userInfo.uid, tile);
 	}
 	rtcEngine->SetVideoWidget(map);
+	ShowWidgets();
+}
+
+//local sources are only in widgetInfos_ when they are shown in the room,
+//with bExtend they go to the extend screen and take no cell here
+void DlgVideoRoom::UpdateCapacity()
+{
+	int localTiles = 0;
+	for (int i = 0; i < widgetInfos_.size(); ++i) {
+		if (rtcEngine->IsLocalUid(widgetInfos_[i].userInfo.uid))
+			++localTiles;
+	}
+	grid_.SetLocalTiles(localTiles);
+	widgetsCount = grid_.Capacity();
+	int lastPage = widgetInfos_.isEmpty() ? 0 : (widgetInfos_.size() - 1) / widgetsCount;
+	curPage = (std::min)(curPage, lastPage);
 }
 
+int DlgVideoRoom::PageTileCount() const
+{
+	int count = (int)widgetInfos_.size() - curPage * widgetsCount;
+	return count < 0 ? 0 : (std::min)(count, widgetsCount);
+}
+
+//only occupied cells get a tile, tiles past the page go idle in the pool
 void DlgVideoRoom::ShowWidgets()
 {
-	if (widgetInfos_.size() < 3) {
-		videoWidget[2]->hide();
-		videoWidget[3]->hide();
-		update();
+	if (!gridWidget_)
+		return;
+	int count = PageTileCount();
+	tiles_.SetUsed(count);
+	QRect area = gridWidget_->rect();
+	if (fullUid_ != 0) {
+		for (int i = 0; i < count; ++i) {
+			VideoWidget* tile = tiles_.Tile(i);
+			if (tile->GetUID() == fullUid_) {
+				tile->SetTileGeometry(area);
+				tile->show();
+			}
+			else
+				tile->hide();
+		}
+		return;
 	}
-	else if (widgetInfos_.size() < 5) {
-		videoWidget[2]->show();
-		videoWidget[3]->show();
+
+	float scale = initRate / rate;
+	QSize maxCell(int(videoW / rate), int(videoH / rate));
+	const QVector<QRect>& cells = grid_.Cells(count, area, (int)(36 * scale), maxCell);
+	for (int i = 0; i < count; ++i) {
+		VideoWidget* tile = tiles_.Tile(i);
+		if (i < cells.size()) {
+			tile->SetTileGeometry(cells[i]);
+			tile->show();
+		}
+		else
+			tile->hide();
 	}
+	update();
 }
 
 void DlgVideoRoom::ResetWidgets()
 {
-	for (int i = 0; i < widgetsCount; ++i) {
-		if (videoWidget[i]->GetUID() == setting.userInfo2.uid)
+	for (int i = 0; i < tiles_.Size(); ++i) {
+		if (tiles_.At(i)->GetUID() == setting.userInfo2.uid)
 			rtcEngine->PauseVideoSource2(true);
-		videoWidget[i]->Reset();
+		tiles_.At(i)->Reset();
 	}
 }
 
+void DlgVideoRoom::SetStudentType(STUDENT_1VN_TYPE type)
+{
+	setting.studentType = type;
+	grid_.SetMode(type);
+	curPage = 0;
+	rtcEngine->ResetVideoWidgets();
+	ResetWidgets();
+	UpdateShowVideos();
+}
+
 void DlgVideoRoom::RequestUserName(unsigned int uid)
 {
 	if (rtcEngine->IsJoined()) {
@@ -107,6 +171,7 @@ void DlgVideoRoom::on_closeButton_clicked()
 		}
 		rtcEngine->VideoSourceLeave(setting.className.toUtf8(), setting.userInfo.uid);
 		rtcEngine->SetJoined(false);
+		rtcEngine->LeaveExtraVideoSources();
 		CloseDlg();
 		emit closeRoom(false);
 		dlg.close();
@@ -118,8 +183,7 @@ void DlgVideoRoom::CloseDlg()
 	curPage = 0;
 	ResetWidgets();
 	widgetInfos_.clear();
-	videoWidget[2]->hide();
-	videoWidget[3]->hide();
+	ShowWidgets();
 	hide();
 	rtcEngine->ResetVideoWidgets();
 }
@@ -148,13 +212,9 @@ void DlgVideoRoom::on_settingDlg_close()
 	if (setting.enabledVideoSource2) {
 		if (!rtcEngine->IsJoined2()) {
 			rtcEngine->SetJoined2(true);
-			bool subscribe = !rtcEngine->IsvideoSource1Subscribe();
-			rtcEngine->VideoSource2JoinChannel(setting.enabledVideoSource2, "", setting.className.toUtf8(), setting.userInfo2.uid, subscribe, subscribe);
+			rtcEngine->VideoSource2JoinChannel(setting.enabledVideoSource2, "", setting.className.toUtf8(), setting.userInfo2.uid);
 			onUserJoined(setting.userInfo2.uid, 0);
 		}
-		else if (!rtcEngine->IsJoined()) {//
-			rtcEngine->UpdateVideoSource2Subscribe(true);
-		}
 	}
 	else {
 		if (rtcEngine->IsJoined2()) {
@@ -163,6 +223,24 @@ void DlgVideoRoom::on_settingDlg_close()
 			onUserOffline(setting.userInfo2.uid, 0);
 		}
 	}
+
+	//document camera and screen share
+	if (rtcEngine->SyncVideoSource(VIDEO_SOURCE_CAMERA_SECONDARY, setting.enabledVideoSource3, setting.className, setting.userInfo3.uid)) {
+		if (setting.enabledVideoSource3)
+			onUserJoined(setting.userInfo3.uid, 0);
+		else
+			onUserOffline(setting.userInfo3.uid, 0);
+	}
+	if (rtcEngine->SyncVideoSource(VIDEO_SOURCE_SCREEN, setting.enabledScreenShare, setting.className, setting.userInfo4.uid)) {
+		if (setting.enabledScreenShare)
+			onUserJoined(setting.userInfo4.uid, 0);
+		else
+			onUserOffline(setting.userInfo4.uid, 0);
+	}
+
+	//class type chosen on the video settings page
+	if (setting.studentType != grid_.Mode())
+		SetStudentType(setting.studentType);
 }
 
 void DlgVideoRoom::on_settingsButton_clicked()
@@ -233,12 +311,33 @@ void DlgVideoRoom::showEvent(QShowEvent *event)
 		}
 	}
 
+	//document camera and screen share
+	const VIDEO_SOURCE_KIND extraKinds[] = { VIDEO_SOURCE_CAMERA_SECONDARY, VIDEO_SOURCE_SCREEN };
+	const UserInfo extraUsers[] = { setting.userInfo3, setting.userInfo4 };
+	for (int k = 0; k < 2; ++k) {
+		if (!rtcEngine->IsVideoSourceJoined(extraKinds[k]))
+			continue;
+		bool bFind = false;
+		for (int i = 0; i < widgetInfos_.size(); ++i) {
+			if (widgetInfos_[i].userInfo.uid == extraUsers[k].uid)
+				bFind = true;
+		}
+		if (!bFind) {
+			WidgetInfo info = { extraUsers[k], false, false };
+			widgetInfos_.push_back(info);
+		}
+	}
+
 	if (setting.enabledVideoSource2) {
-		rtcEngine->OpenVideoSource2(setting.videoSource2Url);
 		connect(AgoraRtcEngine::GetAgoraRtcEngine(), &AgoraRtcEngine::openPlayerComplete,
-			this, &DlgVideoRoom::on_openPlayerComplete);
+			this, &DlgVideoRoom::on_openPlayerComplete, Qt::UniqueConnection);
 		connect(AgoraRtcEngine::GetAgoraRtcEngine(), &AgoraRtcEngine::playerError,
-			this, &DlgVideoRoom::on_playerError);
+			this, &DlgVideoRoom::on_playerError, Qt::UniqueConnection);
+		//usually open and playing since the login
+		if (rtcEngine->Player()->IsOpened())
+			on_openPlayerComplete();
+		else
+			rtcEngine->Player()->Open(setting.videoSource2Url, true);
 	}
 	else
 		UpdateShowVideos();
@@ -253,9 +352,32 @@ void DlgVideoRoom::keyPressEvent(QKeyEvent* event)
 	if (event->key() == VK_RETURN) {
 		return;
 	}
+	//F3-F5 debug switches of the video tiles
+	if (VideoWidget::HandleDebugKey(event->key())) {
+		for (int i = 0; i < tiles_.Used(); ++i)
+			tiles_.At(i)->update();
+		return;
+	}
+	//F6 starts or stops the local Y4M recording, also a row of the video settings;
+	//F7 captures every stream with timing for the frame_replay program.
+	//Each key only stops its own recording
+	if (event->key() == Qt::Key_F6 || event->key() == Qt::Key_F7) {
+		RECORD_FORMAT format = event->key() == Qt::Key_F6 ? RECORD_FORMAT_Y4M : RECORD_FORMAT_CAPTURE;
+		bool running = rtcEngine->IsRecording() && rtcEngine->RecordingFormat() == format;
+		if (!rtcEngine->SetRecording(format, !running))
+			qDebug() << "recorder: key ignored, the other recording is running";
+		return;
+	}
 
 	QDialog::keyPressEvent(event);
 }
+
+bool DlgVideoRoom::eventFilter(QObject* watched, QEvent* event)
+{
+	if (watched == gridWidget_ && event->type() == QEvent::Resize)
+		ShowWidgets();
+	return QRoundCornerDialog::eventFilter(watched, event);
+}
 void DlgVideoRoom::on_openPlayerComplete()
 {
 	UpdateShowVideos();
@@ -276,30 +398,36 @@ void DlgVideoRoom::on_playerError(int ec)
 	return;
 }
 
+//the title shows a running recording, a failed write is reported once
+void DlgVideoRoom::onRecordingChanged(bool recording, bool failed)
+{
+	if (!recording)
+		ui.labTitle->setText(titleText_);
+	else if (rtcEngine->RecordingFormat() == RECORD_FORMAT_Y4M)
+		ui.labTitle->setText(QString::fromStdWString(L"● 录制中"));
+	else
+		ui.labTitle->setText(QString::fromStdWString(L"● 采集中"));
+	if (!failed)
+		return;
+	QString strInfo = QString::fromStdWString(L"录制文件写入失败，录制已停止");
+	DlgInfo dlg(strInfo, rate, rate2);
+	connect(&dlg, &DlgInfo::parentMaxSignal,
+		this, &DlgVideoRoom::on_parentMax_slot);
+	if (!bMax && dlg.IsMax())
+		dlg.maxButtonChange(true);
+	dlg.exec();
+}
+
 void DlgVideoRoom::on_fullScreen(unsigned int uid, bool bFull)
 {
 	if (!bMax) {
 		on_fullMaxButton_clicked(!bFull);
 	}
-	for (int i = 0; i < widgetsCount; ++i) {
-		if (videoWidget[i]->GetUID() == uid) {
-			if (bFull) 
-				videoWidget[i]->MaximizeWidget(this->width() , this->height());
-			else 
-				videoWidget[i]->RestoreWidget();
-			videoWidget[i]->UpdateButtonPos();
-		}
-		else {
-			if (bFull)
-				videoWidget[i]->hide();
-			else if (i < 2)
-				videoWidget[i]->show();
-			else if(i > 1)
-				widgetInfos_.size() > 2 ? videoWidget[i]->show() : videoWidget[i]->hide();
-				
-		}
-	}
+	//the grid area takes the whole dialog while one tile is full screen
+	fullUid_ = bFull ? uid : 0;
+	gridWidget_->setMinimumSize(bFull ? size() : QSize(0, 0));
 	ShowTopAndBottom(!bFull);
+	ShowWidgets();
 }
 
 void DlgVideoRoom::on_muteVideo(unsigned int uid, bool mute)
@@ -339,6 +467,10 @@ void DlgVideoRoom::onUserJoined(unsigned int uid, int elapsed)
 		userInfo = setting.userInfo;
 	else if (uid == setting.userInfo2.uid)
 		userInfo = setting.userInfo2;
+	else if (uid == setting.userInfo3.uid)
+		userInfo = setting.userInfo3;
+	else if (uid == setting.userInfo4.uid)
+		userInfo = setting.userInfo4;
 
 	WidgetInfo info = { userInfo , false, false };
 	widgetInfos_.push_back(info);
@@ -369,6 +501,8 @@ void DlgVideoRoom::onUserOffline(unsigned int uid, int elapsed)
 	for (int i = 0; i < widgetInfos_.size(); ++i) {
 		qDebug() << "onUserOffline: uid " << widgetInfos_[i].userInfo.uid << ", name " << widgetInfos_[i].userInfo.name;
 	}
+	if (fullUid_ != 0 && uid == fullUid_)
+		on_fullScreen(uid, false);
 	int leaveIndex = -1;
 	for (int i = 0; i < widgetInfos_.size(); ++i) {
 		if (widgetInfos_[i].userInfo.uid == uid) {
@@ -420,9 +554,9 @@ void DlgVideoRoom::onStreamMessage(unsigned uid, QString message)
 			}
 		}
 
-		for (int i = 0; i < widgetsCount; ++i) {
-			if (videoWidget[i]->GetUID() == uid) {
-				videoWidget[i]->SetWidgetInfo(info);
+		for (int i = 0; i < tiles_.Used(); ++i) {
+			if (tiles_.At(i)->GetUID() == uid) {
+				tiles_.At(i)->SetWidgetInfo(info);
 			}
 		}
 	}
@@ -6,8 +6,10 @@
 #include "QRoundCornerDialog.h"
 #include <QVector>
 #include "SettingsData.h"
+#include "LayoutEngine.h"
+#include "VideoGrid.h"
+#include "VideoTilePool.h"
 #include <unordered_set>
-#define VIDEO_COUNT 4
 class VideoWidget;
 class AgoraCourse;
 class DlgSettings;
@@ -25,49 +27,50 @@ protected:
 	virtual void showEvent(QShowEvent *event) override;
 	virtual void hideEvent(QHideEvent *event) override;
 	virtual void keyPressEvent(QKeyEvent* event) override;
+	virtual bool eventFilter(QObject* watched, QEvent* event) override;
 private:
 	Ui::DlgVideoRoom ui;
 	QWidget* agoraCourse = nullptr;
 	DlgSettings* dlgSettings = nullptr;
 	bool bMax = true;
-	//title
-	int titleHeight = 67;
-	int titleFontSize = 48;
-	int titleTopMargin = 48;
-	int titleBottomMargin = 20;
-	int labTitleW = 192;
-	int labTitleH = 67;
-
 	//video widget
 	int videoW = 710;
 	int videoH = 400;
-	int videoSpace = 36;
-	int videoMargin = 73;
-	int pageBtnW = 52;
-	int pageBtnH = 52;
-	int midMargin = 98;
-	int bottomTopMargin = 18;
-	
-	void setTopButtonLayout();
-	void setTitleLayout();
-	void setOptionLayout();
-	void setBottomLabel();
+	LayoutEngine layout_;
+
+	void BuildLayoutSpec();
+	void ApplyLayout();
 	void showPage(bool bShow);
 	void InitDlg();
 	void ShowTopAndBottom(bool bShow);
 	void UpdateLayout();
 
 	void UpdateShowVideos();
+	//places the tiles of the current page on the grid
 	void ShowWidgets();
 	void ResetWidgets();
 	void RequestUserName(unsigned int uid);
+	//new tile for the pool
+	VideoWidget* CreateTile();
+	int PageTileCount() const;
+	//widgetsCount from the class type and the local tiles in widgetInfos_
+	void UpdateCapacity();
+	void SetStudentType(STUDENT_1VN_TYPE type);
 	
-	VideoWidget* videoWidget[VIDEO_COUNT];
+	//parent of the tiles, fills the video area of the dialog
+	QWidget* gridWidget_ = nullptr;
+	VideoGrid grid_;
+	VideoTilePool tiles_;
+	//tile shown over the whole dialog, 0 for the grid
+	unsigned int fullUid_ = 0;
 	QVector<WidgetInfo> widgetInfos_;
 	int curPage = 0;
-	const int widgetsCount = 4;
+	//tiles per page, the capacity of the grid: N students plus the local tiles
+	int widgetsCount = 4;
 
 	QString cmdRequestUserName = "requestUserName";
+	//text of labTitle while nothing records
+	QString titleText_;
 
 public :
 	void CloseDlg();
@@ -79,6 +82,7 @@ private slots:
 	void on_closeButton_clicked();
 	void on_openPlayerComplete();
 	void on_playerError(int ec);
+	void onRecordingChanged(bool recording, bool failed);
 	void on_fullScreen(unsigned int uid, bool bFull);
 	void on_muteVideo(unsigned int uid, bool mute);
 	void on_muteAudio(unsigned int uid, bool mute);
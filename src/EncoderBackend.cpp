@@ -0,0 +1,131 @@
+#include "EncoderBackend.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+#ifdef _WIN32
+#include <dxgi.h>
+#endif
+
+#define VENDOR_NVIDIA 0x10DE
+#define VENDOR_INTEL 0x8086
+
+//vendors of the hardware adapters, software adapters are skipped
+static unsigned int probeEncoderTypes()
+{
+	unsigned int types = 1u << ENCODER_SOFTWARE;
+#ifdef _WIN32
+	IDXGIFactory1* factory = nullptr;
+	if (FAILED(CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&factory)))
+		return types;
+	IDXGIAdapter1* adapter = nullptr;
+	for (UINT i = 0; factory->EnumAdapters1(i, &adapter) != DXGI_ERROR_NOT_FOUND; ++i) {
+		DXGI_ADAPTER_DESC1 desc;
+		if (SUCCEEDED(adapter->GetDesc1(&desc)) && !(desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE)) {
+			if (desc.VendorId == VENDOR_NVIDIA)
+				types |= 1u << ENCODER_NVIDIA;
+			else if (desc.VendorId == VENDOR_INTEL)
+				types |= 1u << ENCODER_INTEL;
+			qDebug() << "gpu" << QString::fromWCharArray(desc.Description) << Qt::hex << desc.VendorId;
+		}
+		adapter->Release();
+	}
+	factory->Release();
+#endif
+	return types;
+}
+
+bool encoderTypeAvailable(int type)
+{
+	static unsigned int types = probeEncoderTypes();
+	return type >= ENCODER_SOFTWARE && type <= ENCODER_INTEL && (types & (1u << type));
+}
+
+const char* encoderTypeName(int type)
+{
+	switch (type) {
+	case ENCODER_DEFAULT:
+		return "default";
+	case ENCODER_NVIDIA:
+		return "nvidia";
+	case ENCODER_INTEL:
+		return "intel";
+	case ENCODER_SOFTWARE:
+	default:
+		return "software";
+	}
+}
+
+void EncoderBackend::Start(int requested, int active)
+{
+	QMutexLocker lock(&mutex_);
+	report_ = EncoderReport();
+	report_.requested = requested;
+	report_.active = active;
+	report_.fellBack = requested != active;
+	running_ = true;
+	failTicks_ = 0;
+	captureSum_ = 0;
+	encodeSum_ = 0;
+}
+
+void EncoderBackend::SetTargetFps(int fps)
+{
+	QMutexLocker lock(&mutex_);
+	targetFps_ = fps;
+	failTicks_ = 0;
+}
+
+bool EncoderBackend::OnLocalVideoStats(const agora::rtc::LocalVideoStats& stats)
+{
+	QMutexLocker lock(&mutex_);
+	if (!running_)
+		return false;
+	report_.accelerated = stats.hwEncoderAccelerating != 0;
+	++report_.samples;
+	captureSum_ += stats.captureFrameRate;
+	encodeSum_ += stats.encoderOutputFrameRate;
+	report_.captureFps = captureSum_ / report_.samples;
+	report_.encodeFps = encodeSum_ / report_.samples;
+	report_.encodeMs = report_.encodeFps > 0 ? 1000.0 / report_.encodeFps : 0;
+
+	if (report_.active == ENCODER_SOFTWARE)
+		return false;
+	//a 60 fps camera under a 30 fps encoder, or a camera slower than the encoder, is not a failure
+	int expectedFps = targetFps_;
+	if (stats.captureFrameRate > 0 && (expectedFps <= 0 || stats.captureFrameRate < expectedFps))
+		expectedFps = stats.captureFrameRate;
+	bool failing = !report_.accelerated
+		|| (expectedFps > 0 && stats.encoderOutputFrameRate * 2 < expectedFps);
+	failTicks_ = failing ? failTicks_ + 1 : 0;
+	return failTicks_ == ENCODER_FALLBACK_TICKS;
+}
+
+void EncoderBackend::OnFallBack()
+{
+	QMutexLocker lock(&mutex_);
+	qDebug() << "encoder" << encoderTypeName(report_.active) << "failing, accelerated" << report_.accelerated
+		<< "encode fps" << report_.encodeFps << "capture fps" << report_.captureFps << ", switching to software";
+	report_.active = ENCODER_SOFTWARE;
+	report_.fellBack = true;
+	failTicks_ = 0;
+}
+
+void EncoderBackend::End()
+{
+	QMutexLocker lock(&mutex_);
+	if (!running_)
+		return;
+	running_ = false;
+	qDebug() << "encoder session: requested" << encoderTypeName(report_.requested)
+		<< "active" << encoderTypeName(report_.active) << "fell back" << report_.fellBack
+		<< "accelerated" << report_.accelerated << "capture fps" << report_.captureFps
+		<< "encode fps" << report_.encodeFps << "ms/frame" << report_.encodeMs
+		<< "samples" << report_.samples;
+}
+
+EncoderReport EncoderBackend::Report()
+{
+	QMutexLocker lock(&mutex_);
+	return report_;
+}
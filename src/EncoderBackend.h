@@ -0,0 +1,61 @@
+#ifndef ENCODERBACKEND_H
+#define ENCODERBACKEND_H
+
+#include <IAgoraRtcEngine.h>
+
+#include <QMutex>
+
+#include "SettingsData.h"
+
+//local video stats (2s apart) of a failing hardware encoder before software takes over
+#define ENCODER_FALLBACK_TICKS 3
+
+//encoder of the teacher camera during one session
+typedef struct tagEncoderReport
+{
+	//ENCODER_DEFAULT until a type is chosen in the settings
+	int requested = ENCODER_DEFAULT;
+	int active = ENCODER_DEFAULT;
+	//the sdk encoded on the gpu in the last stats
+	bool accelerated = false;
+	bool fellBack = false;
+	int samples = 0;
+	//session means
+	double captureFps = 0;
+	double encodeFps = 0;
+	//mean time between encoded frames, 1000 / encodeFps
+	double encodeMs = 0;
+}EncoderReport;
+
+//gpu of the vendor is present, probed once; ENCODER_SOFTWARE always is
+bool encoderTypeAvailable(int type);
+const char* encoderTypeName(int type);
+
+// Bookkeeping of the hardware encoder selected by AgoraRtcEngine::SetEncoderType.
+// A hardware encoder that reports software encoding or keeps less than half
+// of the frames it is configured for (or of the captured ones, when the camera
+// is slower) for ENCODER_FALLBACK_TICKS stats is given up.
+// Stats arrive on the sdk thread.
+class EncoderBackend
+{
+public:
+	void Start(int requested, int active);
+	//frame rate of the encoder configuration in use, adaptive steps included
+	void SetTargetFps(int fps);
+	//true when the engine should switch to software
+	bool OnLocalVideoStats(const agora::rtc::LocalVideoStats& stats);
+	void OnFallBack();
+	//logs the report of the session
+	void End();
+	EncoderReport Report();
+private:
+	QMutex mutex_;
+	EncoderReport report_;
+	bool running_ = false;
+	int failTicks_ = 0;
+	int targetFps_ = 0;
+	double captureSum_ = 0;
+	double encodeSum_ = 0;
+};
+
+#endif // ENCODERBACKEND_H
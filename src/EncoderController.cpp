@@ -0,0 +1,172 @@
+#include "EncoderController.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QMutexLocker>
+
+//16:9 heights below the target, the widths follow the target aspect
+static const int ladderHeights[] = { 2160, 1440, 1080, 720, 540, 360 };
+
+//QUALITY_UNKNOWN, QUALITY_UNSUPPORTED and QUALITY_DETECTING say nothing about the uplink
+static bool uplinkKnown(int quality)
+{
+	return quality >= agora::rtc::QUALITY_EXCELLENT && quality <= agora::rtc::QUALITY_DOWN;
+}
+
+static bool uplinkBad(int quality)
+{
+	return quality == agora::rtc::QUALITY_BAD || quality == agora::rtc::QUALITY_VBAD
+		|| quality == agora::rtc::QUALITY_DOWN;
+}
+
+void EncoderController::SetEnabled(bool enabled)
+{
+	agora::rtc::VideoEncoderConfiguration config;
+	{
+		QMutexLocker lock(&mutex_);
+		enabled_ = enabled;
+		overTicks_ = 0;
+		calmTicks_ = 0;
+		//switched off below the top, the camera goes back to the settings choice
+		if (enabled || !active_ || step_ == 0)
+			return;
+		step_ = 0;
+		config = target_;
+		qDebug() << "encoder adaptation off, back to" << config.dimensions.width << "x" << config.dimensions.height
+			<< "@" << config.frameRate;
+	}
+	if (apply_)
+		apply_(config);
+}
+
+void EncoderController::SetTarget(const agora::rtc::VideoEncoderConfiguration& config)
+{
+	QMutexLocker lock(&mutex_);
+	target_ = config;
+	BuildLadderLocked();
+	active_ = true;
+	step_ = 0;
+	overTicks_ = 0;
+	calmTicks_ = 0;
+	lastStepMs_ = QDateTime::currentMSecsSinceEpoch();
+	qDebug() << "encoder ladder" << target_.dimensions.width << "x" << target_.dimensions.height
+		<< "@" << target_.frameRate << "," << ladder_.size() << "steps";
+}
+
+void EncoderController::Reset()
+{
+	QMutexLocker lock(&mutex_);
+	active_ = false;
+	step_ = 0;
+	overTicks_ = 0;
+	calmTicks_ = 0;
+	cpuTotal_ = 0;
+	txQuality_ = 0;
+}
+
+void EncoderController::OnRtcStats(const agora::rtc::RtcStats& stats)
+{
+	QMutexLocker lock(&mutex_);
+	cpuTotal_ = (int)stats.cpuTotalUsage;
+}
+
+void EncoderController::OnNetworkQuality(int txQuality)
+{
+	QMutexLocker lock(&mutex_);
+	txQuality_ = txQuality;
+}
+
+void EncoderController::OnLocalVideoStats(const agora::rtc::LocalVideoStats& stats)
+{
+	agora::rtc::VideoEncoderConfiguration config;
+	{
+		QMutexLocker lock(&mutex_);
+		if (!enabled_ || !active_ || ladder_.isEmpty())
+			return;
+		int fps = ladder_[step_].frameRate;
+		if (stats.captureFrameRate > 0 && stats.captureFrameRate < fps)
+			fps = stats.captureFrameRate;
+		//a slow camera is not an encoder problem, only compare with what was captured
+		bool behind = stats.encoderOutputFrameRate > 0 && stats.encoderOutputFrameRate * 10 < fps * 7;
+		bool cpuHigh = cpuTotal_ >= ENCODER_ADAPT_CPU_HIGH;
+		bool uplinkPoor = uplinkBad(txQuality_);
+		//an unknown uplink neither steps down nor holds a step up
+		bool calm = cpuTotal_ < ENCODER_ADAPT_CPU_LOW && !behind
+			&& (!uplinkKnown(txQuality_) || txQuality_ <= agora::rtc::QUALITY_GOOD);
+
+		overTicks_ = (behind || cpuHigh || uplinkPoor) ? overTicks_ + 1 : 0;
+		calmTicks_ = calm ? calmTicks_ + 1 : 0;
+
+		qint64 now = QDateTime::currentMSecsSinceEpoch();
+		int from = step_;
+		if (overTicks_ >= ENCODER_ADAPT_DOWN_TICKS && step_ + 1 < ladder_.size())
+			++step_;
+		else if (calmTicks_ >= ENCODER_ADAPT_UP_TICKS && step_ > 0
+			&& now - lastStepMs_ >= ENCODER_ADAPT_HOLD_MS)
+			--step_;
+		if (step_ == from)
+			return;
+
+		overTicks_ = 0;
+		calmTicks_ = 0;
+		lastStepMs_ = now;
+		config = ladder_[step_];
+		qDebug() << "encoder step" << from << "->" << step_
+			<< config.dimensions.width << "x" << config.dimensions.height << "@" << config.frameRate
+			<< "bitrate" << config.bitrate
+			<< "cpu" << cpuTotal_ << "encode fps" << stats.encoderOutputFrameRate << "/" << fps
+			<< "tx quality" << txQuality_
+			<< (step_ > from ? (behind ? "encoder behind" : cpuHigh ? "cpu high" : "uplink bad") : "calm");
+	}
+	if (apply_)
+		apply_(config);
+}
+
+int EncoderController::Step()
+{
+	QMutexLocker lock(&mutex_);
+	return step_;
+}
+
+int EncoderController::Steps()
+{
+	QMutexLocker lock(&mutex_);
+	return ladder_.size();
+}
+
+void EncoderController::BuildLadderLocked()
+{
+	ladder_.clear();
+	ladder_.push_back(target_);
+	int width = target_.dimensions.width;
+	int height = target_.dimensions.height;
+	int fps = target_.frameRate;
+	if (width <= 0 || height <= 0 || fps <= 0)
+		return;
+	auto add = [this, width, height, fps](int w, int h, int f) {
+		agora::rtc::VideoEncoderConfiguration config = target_;
+		config.dimensions.width = w;
+		config.dimensions.height = h;
+		config.frameRate = f;
+		//explicit bitrates scale with the pixel rate, the sdk picks standard ones itself
+		if (target_.bitrate > 0)
+			config.bitrate = (int)((long long)target_.bitrate * w * h * f / ((long long)width * height * fps));
+		ladder_.push_back(config);
+	};
+	int f = fps;
+	if (f > 30) {
+		f = 30;
+		add(width, height, f);
+	}
+	int w = width;
+	int h = height;
+	for (int ladderHeight : ladderHeights) {
+		if (ladderHeight >= h)
+			continue;
+		w = (width * ladderHeight / height) & ~1;
+		h = ladderHeight;
+		add(w, h, f);
+	}
+	if (f > 15)
+		add(w, h, 15);
+}
@@ -0,0 +1,61 @@
+#ifndef ENCODERCONTROLLER_H
+#define ENCODERCONTROLLER_H
+
+#include <IAgoraRtcEngine.h>
+
+#include <QMutex>
+#include <QVector>
+#include <functional>
+
+//system cpu in percent that counts as overloaded / idle
+#define ENCODER_ADAPT_CPU_HIGH 85
+#define ENCODER_ADAPT_CPU_LOW 60
+//consecutive local video stats (2s apart) before a step down / up
+#define ENCODER_ADAPT_DOWN_TICKS 2
+#define ENCODER_ADAPT_UP_TICKS 5
+//no step up sooner than this after any step
+#define ENCODER_ADAPT_HOLD_MS 10000
+
+// Steps the teacher camera encoder along a ladder derived from the
+// configured encoder settings: frame rate first, then 16:9 sizes down
+// to 360p, then 15 fps. It steps down when the system cpu is high, the
+// encoder falls behind its frame rate or the uplink is bad, and back up
+// only after a longer calm period. Every step is logged with its reason.
+// Stats arrive on the sdk thread; apply is called without the lock.
+class EncoderController
+{
+public:
+	typedef std::function<void(const agora::rtc::VideoEncoderConfiguration& config)> ApplyFunc;
+	void SetApplyFunc(ApplyFunc apply) { apply_ = apply; }
+	//off restores the target at once, see CSettingsData::adaptiveEncoder
+	void SetEnabled(bool enabled);
+	//top of the ladder, the configuration chosen in the settings
+	void SetTarget(const agora::rtc::VideoEncoderConfiguration& config);
+	//the camera left the channel
+	void Reset();
+
+	void OnRtcStats(const agora::rtc::RtcStats& stats);
+	void OnNetworkQuality(int txQuality);
+	void OnLocalVideoStats(const agora::rtc::LocalVideoStats& stats);
+
+	//0 is the target
+	int Step();
+	int Steps();
+private:
+	void BuildLadderLocked();
+
+	QMutex mutex_;
+	ApplyFunc apply_;
+	bool enabled_ = false;
+	bool active_ = false;
+	agora::rtc::VideoEncoderConfiguration target_;
+	QVector<agora::rtc::VideoEncoderConfiguration> ladder_;
+	int step_ = 0;
+	int overTicks_ = 0;
+	int calmTicks_ = 0;
+	qint64 lastStepMs_ = 0;
+	int cpuTotal_ = 0;
+	int txQuality_ = 0;
+};
+
+#endif // ENCODERCONTROLLER_H
@@ -0,0 +1,124 @@
+#include "FrameCapture.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+static size_t alignCapture(size_t size)
+{
+	return (size + 7) & ~(size_t)7;
+}
+
+size_t frameCapturePlaneSize(int width, int height)
+{
+	return (size_t)width * height + 2 * (size_t)chromaSize(width) * chromaSize(height);
+}
+
+bool writeFrameCaptureHeader(FILE* file, int64_t startUs)
+{
+	FrameCaptureHeader header;
+	header.magic = FRAME_CAPTURE_MAGIC;
+	header.version = FRAME_CAPTURE_VERSION;
+	header.startUs = startUs;
+	return fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+bool writeFrameCaptureRecord(FILE* file, const FrameCaptureRecord& record, const uint8_t* planes)
+{
+	static const uint8_t padding[8] = { 0 };
+	size_t size = frameCapturePlaneSize(record.width, record.height);
+	if (fwrite(&record, sizeof(record), 1, file) != 1)
+		return false;
+	if (fwrite(planes, 1, size, file) != size)
+		return false;
+	size_t pad = alignCapture(size) - size;
+	return pad == 0 || fwrite(padding, 1, pad, file) == pad;
+}
+
+FrameCaptureReader::FrameCaptureReader()
+{
+}
+
+FrameCaptureReader::~FrameCaptureReader()
+{
+	Close();
+}
+
+bool FrameCaptureReader::Open(const QString& path)
+{
+	Close();
+	file_.setFileName(path);
+	if (!file_.open(QIODevice::ReadOnly)) {
+		qDebug() << "capture: cannot open" << path;
+		return false;
+	}
+	qint64 size = file_.size();
+	if (size < (qint64)sizeof(FrameCaptureHeader) || !(data_ = file_.map(0, size))) {
+		qDebug() << "capture: cannot map" << path;
+		Close();
+		return false;
+	}
+	const FrameCaptureHeader* header = reinterpret_cast<const FrameCaptureHeader*>(data_);
+	if (header->magic != FRAME_CAPTURE_MAGIC || header->version != FRAME_CAPTURE_VERSION) {
+		qDebug() << "capture: not a capture file" << path;
+		Close();
+		return false;
+	}
+
+	size_t offset = sizeof(FrameCaptureHeader);
+	while (offset + sizeof(FrameCaptureRecord) <= (size_t)size) {
+		const FrameCaptureRecord* record = reinterpret_cast<const FrameCaptureRecord*>(data_ + offset);
+		if (record->width <= 0 || record->height <= 0)
+			break;
+		size_t planes = alignCapture(frameCapturePlaneSize(record->width, record->height));
+		//a capture cut short keeps its complete records
+		if (offset + sizeof(FrameCaptureRecord) + planes > (size_t)size)
+			break;
+		records_.push_back(record);
+		offset += sizeof(FrameCaptureRecord) + planes;
+	}
+	qDebug() << "capture:" << path << records_.size() << "frames";
+	return !records_.empty();
+}
+
+void FrameCaptureReader::Close()
+{
+	records_.clear();
+	if (data_) {
+		file_.unmap(data_);
+		data_ = nullptr;
+	}
+	file_.close();
+}
+
+void FrameCaptureReader::Frame(int index, agora::media::base::VideoFrame& videoFrame, VideoColorInfo& color) const
+{
+	const FrameCaptureRecord& record = *records_[index];
+	const uint8_t* planes = reinterpret_cast<const uint8_t*>(&record + 1);
+	size_t luma = (size_t)record.width * record.height;
+	size_t chroma = (size_t)chromaSize(record.width) * chromaSize(record.height);
+	videoFrame.type = agora::media::base::VIDEO_PIXEL_I420;
+	videoFrame.width = record.width;
+	videoFrame.height = record.height;
+	videoFrame.yStride = record.width;
+	videoFrame.uStride = chromaSize(record.width);
+	videoFrame.vStride = chromaSize(record.width);
+	//read only, CopyVideoFrame never writes its source
+	videoFrame.yBuffer = const_cast<uint8_t*>(planes);
+	videoFrame.uBuffer = const_cast<uint8_t*>(planes + luma);
+	videoFrame.vBuffer = const_cast<uint8_t*>(planes + luma + chroma);
+	videoFrame.rotation = record.rotation;
+	videoFrame.renderTimeMs = record.timeUs / 1000;
+	color.matrix = record.colorMatrix;
+	color.fullRange = record.fullRange != 0;
+}
+
+std::vector<unsigned int> FrameCaptureReader::Uids() const
+{
+	std::vector<unsigned int> uids;
+	for (size_t i = 0; i < records_.size(); ++i) {
+		if (std::find(uids.begin(), uids.end(), records_[i]->uid) == uids.end())
+			uids.push_back(records_[i]->uid);
+	}
+	return uids;
+}
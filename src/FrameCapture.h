@@ -0,0 +1,63 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <IAgoraMediaEngine.h>
+
+#include <QFile>
+#include <QString>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "video_frame_copy.h"
+
+// Frame capture file, written by FrameRecorder in RECORD_FORMAT_CAPTURE
+// and read back by FrameReplay. A FrameCaptureHeader is followed by
+// records: a FrameCaptureRecord, then the packed I420 planes, padded to
+// 8 bytes so the file can be mapped and used in place.
+#define FRAME_CAPTURE_MAGIC 0x43465444 // "DTFC"
+#define FRAME_CAPTURE_VERSION 1
+
+struct FrameCaptureHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	int64_t startUs;
+};
+
+struct FrameCaptureRecord
+{
+	uint32_t uid;
+	int32_t width;
+	int32_t height;
+	int32_t rotation;
+	//capture time relative to FrameCaptureHeader::startUs
+	int64_t timeUs;
+	int32_t colorMatrix;
+	int32_t fullRange;
+};
+
+size_t frameCapturePlaneSize(int width, int height);
+bool writeFrameCaptureHeader(FILE* file, int64_t startUs);
+bool writeFrameCaptureRecord(FILE* file, const FrameCaptureRecord& record, const uint8_t* planes);
+
+// Maps a capture file and indexes its records, frames point into the mapping.
+class FrameCaptureReader
+{
+public:
+	FrameCaptureReader();
+	~FrameCaptureReader();
+	bool Open(const QString& path);
+	void Close();
+	int Count() const { return (int)records_.size(); }
+	const FrameCaptureRecord& Record(int index) const { return *records_[index]; }
+	void Frame(int index, agora::media::base::VideoFrame& videoFrame, VideoColorInfo& color) const;
+	//uids in order of their first frame
+	std::vector<unsigned int> Uids() const;
+private:
+	QFile file_;
+	uchar* data_ = nullptr;
+	std::vector<const FrameCaptureRecord*> records_;
+};
+
+#endif // FRAMECAPTURE_H
@@ -0,0 +1,215 @@
+#include "FrameRecorder.h"
+#include "FrameCapture.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <chrono>
+
+static int64_t NowUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FrameRecorder::FrameRecorder()
+	: recording_(false)
+	, dropped_(0)
+{
+	for (int i = 0; i < RECORDER_POOL_FRAMES; ++i) {
+		frames_.emplace_back(new PooledFrame());
+		free_.push_back(frames_.back().get());
+	}
+}
+
+FrameRecorder::~FrameRecorder()
+{
+	Stop();
+}
+
+bool FrameRecorder::Start(const QString& directory, RECORD_FORMAT format)
+{
+	if (recording_)
+		return format == format_;
+	if (!QDir().mkpath(directory)) {
+		qDebug() << "recorder: cannot create" << directory;
+		return false;
+	}
+	if (thread_.joinable())
+		thread_.join();
+	directory_ = directory;
+	prefix_ = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
+	format_ = format;
+	startUs_ = NowUs();
+	dropped_ = 0;
+	recording_ = true;
+	thread_ = std::thread(&FrameRecorder::Run, this);
+	qDebug() << "recorder: started in" << directory;
+	return true;
+}
+
+//queued frames are written out before the files are closed
+void FrameRecorder::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		recording_ = false;
+	}
+	cond_.notify_all();
+	//the writer may have stopped on its own after a failed write
+	if (!thread_.joinable())
+		return;
+	thread_.join();
+	qDebug() << "recorder: stopped, dropped" << (unsigned long long)dropped_;
+}
+
+void FrameRecorder::SetFrameRate(unsigned int uid, int fps)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (fps > 0)
+		frameRates_[uid] = fps;
+}
+
+bool FrameRecorder::Push(unsigned int uid, const agora::media::base::VideoFrame& videoFrame, const VideoColorInfo& color)
+{
+	if (!recording_ || uid == 0 || videoFrame.width <= 0 || videoFrame.height <= 0)
+		return false;
+	PooledFrame* frame = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (free_.empty()) {
+			++dropped_;
+			return false;
+		}
+		frame = free_.back();
+		free_.pop_back();
+		auto rate = frameRates_.find(uid);
+		frame->fps = rate != frameRates_.end() ? rate->second : RECORDER_DEFAULT_FPS;
+	}
+
+	//the sdk frame is only valid during the callback, this is the one copy
+	size_t luma = (size_t)videoFrame.width * videoFrame.height;
+	size_t chroma = (size_t)chromaSize(videoFrame.width) * chromaSize(videoFrame.height);
+	if (frame->planes.size() < luma + 2 * chroma)
+		frame->planes.resize(luma + 2 * chroma);
+	agora::media::base::VideoFrame packed;
+	packed.yBuffer = frame->planes.data();
+	packed.uBuffer = frame->planes.data() + luma;
+	packed.vBuffer = frame->planes.data() + luma + chroma;
+	copyI420Frame(videoFrame, packed);
+	frame->uid = uid;
+	frame->width = videoFrame.width;
+	frame->height = videoFrame.height;
+	frame->rotation = videoFrame.rotation;
+	frame->timeUs = NowUs() - startUs_;
+	frame->color = color;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		//stopped while copying, the writer may be gone already
+		if (!recording_) {
+			free_.push_back(frame);
+			return false;
+		}
+		queue_.push_back(frame);
+	}
+	cond_.notify_one();
+	return true;
+}
+
+void FrameRecorder::Run()
+{
+	bool failed = false;
+	std::unique_lock<std::mutex> lock(mutex_);
+	for (;;) {
+		cond_.wait(lock, [this] { return !queue_.empty() || !recording_; });
+		if (queue_.empty())
+			break;
+		PooledFrame* frame = queue_.front();
+		queue_.pop_front();
+		lock.unlock();
+		bool written = format_ == RECORD_FORMAT_CAPTURE ? WriteCapture(*frame) : Write(*frame);
+		lock.lock();
+		free_.push_back(frame);
+		if (!written) {
+			qDebug() << "recorder: write failed, recording stopped";
+			recording_ = false;
+			free_.insert(free_.end(), queue_.begin(), queue_.end());
+			queue_.clear();
+			failed = true;
+			break;
+		}
+	}
+	lock.unlock();
+	CloseOutputs();
+	if (failed && failed_)
+		failed_();
+}
+
+bool FrameRecorder::Write(const PooledFrame& frame)
+{
+	Output& output = outputs_[frame.uid];
+	if (output.file && (output.width != frame.width || output.height != frame.height)) {
+		fclose(output.file);
+		output.file = nullptr;
+		++output.segment;
+	}
+	if (!output.file) {
+		QString name = QString("%1/%2_%3").arg(directory_).arg(prefix_).arg(frame.uid);
+		if (output.segment > 0)
+			name += QString("_%1").arg(output.segment);
+		name += ".y4m";
+		output.file = fopen(QDir::toNativeSeparators(name).toLocal8Bit().constData(), "wb");
+		if (!output.file) {
+			qDebug() << "recorder: cannot open" << name;
+			return false;
+		}
+		output.width = frame.width;
+		output.height = frame.height;
+		//I420 from the sdk is left sited (mpeg2), the rate is the one reported for the stream
+		if (fprintf(output.file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420mpeg2 XCOLORRANGE=%s\n", frame.width,
+			frame.height, frame.fps, frame.color.fullRange ? "FULL" : "LIMITED") < 0) {
+			qDebug() << "recorder: cannot write" << name;
+			return false;
+		}
+	}
+	size_t luma = (size_t)frame.width * frame.height;
+	size_t chroma = (size_t)chromaSize(frame.width) * chromaSize(frame.height);
+	if (fputs("FRAME\n", output.file) == EOF)
+		return false;
+	return fwrite(frame.planes.data(), 1, luma + 2 * chroma, output.file) == luma + 2 * chroma;
+}
+
+bool FrameRecorder::WriteCapture(const PooledFrame& frame)
+{
+	if (!capture_) {
+		QString name = QString("%1/%2.dtfc").arg(directory_).arg(prefix_);
+		capture_ = fopen(QDir::toNativeSeparators(name).toLocal8Bit().constData(), "wb");
+		if (!capture_ || !writeFrameCaptureHeader(capture_, startUs_)) {
+			qDebug() << "recorder: cannot open" << name;
+			return false;
+		}
+	}
+	FrameCaptureRecord record;
+	record.uid = frame.uid;
+	record.width = frame.width;
+	record.height = frame.height;
+	record.rotation = frame.rotation;
+	record.timeUs = frame.timeUs;
+	record.colorMatrix = frame.color.matrix;
+	record.fullRange = frame.color.fullRange ? 1 : 0;
+	return writeFrameCaptureRecord(capture_, record, frame.planes.data());
+}
+
+void FrameRecorder::CloseOutputs()
+{
+	if (capture_) {
+		fclose(capture_);
+		capture_ = nullptr;
+	}
+	for (auto iter = outputs_.begin(); iter != outputs_.end(); ++iter) {
+		if (iter->second.file)
+			fclose(iter->second.file);
+	}
+	outputs_.clear();
+}
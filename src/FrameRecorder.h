@@ -0,0 +1,102 @@
+#ifndef FRAMERECORDER_H
+#define FRAMERECORDER_H
+
+#include <IAgoraMediaEngine.h>
+
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "video_frame_copy.h"
+
+//frames in flight between the sdk threads and the writer, more are dropped
+#define RECORDER_POOL_FRAMES 16
+//Y4M rate of a stream whose rate was not reported yet
+#define RECORDER_DEFAULT_FPS 30
+
+enum RECORD_FORMAT
+{
+	//one raw Y4M file per uid
+	RECORD_FORMAT_Y4M = 0,
+	//every uid in one FrameCapture file with timing, for FrameReplay
+	RECORD_FORMAT_CAPTURE
+};
+
+// Local recording tap of the frame pipeline, see RECORD_FORMAT.
+// Push runs on the sdk video threads: the frame is copied once into a
+// pooled buffer and queued, when the writer falls behind and the pool is
+// empty the frame is dropped so the sdk thread never waits on the disk.
+// A background thread writes the queue out; in Y4M a size change starts a new file.
+// A failed write stops the recording, IsRecording turns false and the
+// failed function is called on the writer thread.
+class FrameRecorder
+{
+public:
+	typedef std::function<void()> FailedFunc;
+	FrameRecorder();
+	~FrameRecorder();
+	//false when the directory cannot be created or a recording of the other format runs
+	bool Start(const QString& directory, RECORD_FORMAT format = RECORD_FORMAT_Y4M);
+	void Stop();
+	bool IsRecording() const { return recording_; }
+	//format of the running or last recording
+	RECORD_FORMAT Format() const { return format_; }
+	void SetFailedFunc(FailedFunc failed) { failed_ = failed; }
+	//sdk thread, false when the frame was dropped or recording is off
+	bool Push(unsigned int uid, const agora::media::base::VideoFrame& videoFrame, const VideoColorInfo& color);
+	//rate of the uid stream for the Y4M header, RECORDER_DEFAULT_FPS until known
+	void SetFrameRate(unsigned int uid, int fps);
+	unsigned long long Dropped() const { return dropped_; }
+private:
+	struct PooledFrame
+	{
+		unsigned int uid = 0;
+		int width = 0;
+		int height = 0;
+		int rotation = 0;
+		int fps = 0;
+		int64_t timeUs = 0;
+		VideoColorInfo color;
+		std::vector<uint8_t> planes;
+	};
+	struct Output
+	{
+		FILE* file = nullptr;
+		int width = 0;
+		int height = 0;
+		int segment = 0;
+	};
+	void Run();
+	bool Write(const PooledFrame& frame);
+	bool WriteCapture(const PooledFrame& frame);
+	void CloseOutputs();
+
+	std::atomic<bool> recording_;
+	std::atomic<unsigned long long> dropped_;
+	QString directory_;
+	QString prefix_;
+	RECORD_FORMAT format_ = RECORD_FORMAT_Y4M;
+	int64_t startUs_ = 0;
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	std::vector<std::unique_ptr<PooledFrame> > frames_;
+	//buffers ready for Push, and filled ones waiting for the writer
+	std::vector<PooledFrame*> free_;
+	std::deque<PooledFrame*> queue_;
+	std::map<unsigned int, int> frameRates_;
+	FailedFunc failed_;
+	//writer thread only
+	std::map<unsigned int, Output> outputs_;
+	FILE* capture_ = nullptr;
+};
+
+#endif // FRAMERECORDER_H
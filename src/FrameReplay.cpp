@@ -0,0 +1,142 @@
+#include "FrameReplay.h"
+#include "VideoTileView.h"
+
+#include <QTimer>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+//size of one replay tile
+#define REPLAY_TILE_WIDTH 640
+#define REPLAY_TILE_HEIGHT 360
+//longest wait for the tiles to paint their last frames before the report
+#define REPLAY_DRAIN_MS 2000
+
+//the report is the output of the program, qDebug is not kept on build machines
+static void replayLog(const QString& text)
+{
+	fprintf(stdout, "replay: %s\n", text.toUtf8().constData());
+	fflush(stdout);
+}
+
+static int64_t NowUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FrameReplay::FrameReplay(QWidget* parent)
+	: QWidget(parent)
+	, stop_(false)
+{
+	setWindowTitle("DualTeacher replay");
+}
+
+FrameReplay::~FrameReplay()
+{
+	Stop();
+}
+
+bool FrameReplay::Open(const QString& path)
+{
+	if (!reader_.Open(path))
+		return false;
+	std::vector<unsigned int> uids = reader_.Uids();
+	int columns = (int)std::ceil(std::sqrt((double)uids.size()));
+	int rows = ((int)uids.size() + columns - 1) / columns;
+	for (size_t i = 0; i < uids.size(); ++i) {
+		VideoTileView* widget = new VideoTileView(1.0f, this);
+		widget->setToolTip(QString::number(uids[i]));
+		widget->setGeometry((i % columns) * REPLAY_TILE_WIDTH, (i / columns) * REPLAY_TILE_HEIGHT,
+			REPLAY_TILE_WIDTH, REPLAY_TILE_HEIGHT);
+		widgets_[uids[i]] = widget;
+	}
+	setFixedSize(columns * REPLAY_TILE_WIDTH, rows * REPLAY_TILE_HEIGHT);
+	return true;
+}
+
+void FrameReplay::Start(float speed)
+{
+	Stop();
+	speed_ = speed;
+	stop_ = false;
+	thread_ = std::thread(&FrameReplay::Run, this);
+}
+
+void FrameReplay::Stop()
+{
+	stop_ = true;
+	if (thread_.joinable())
+		thread_.join();
+}
+
+void FrameReplay::Run()
+{
+	int64_t start = NowUs();
+	int64_t firstUs = reader_.Count() > 0 ? reader_.Record(0).timeUs : 0;
+	int frames = 0;
+	for (int i = 0; i < reader_.Count() && !stop_; ++i) {
+		const FrameCaptureRecord& record = reader_.Record(i);
+		if (speed_ > 0) {
+			int64_t due = start + (int64_t)((record.timeUs - firstUs) / speed_);
+			int64_t now = NowUs();
+			if (due > now)
+				std::this_thread::sleep_for(std::chrono::microseconds(due - now));
+		}
+		auto iter = widgets_.find(record.uid);
+		if (iter == widgets_.end())
+			continue;
+		agora::media::base::VideoFrame videoFrame;
+		VideoColorInfo color;
+		reader_.Frame(i, videoFrame, color);
+		iter->second->CopyVideoFrame(videoFrame, color);
+		QMetaObject::invokeMethod(iter->second, "renderFrame", Qt::QueuedConnection);
+		++frames;
+	}
+	frames_ = frames;
+	elapsedUs_ = NowUs() - start;
+	drainStartUs_ = 0;
+	QMetaObject::invokeMethod(this, "onFinished", Qt::QueuedConnection);
+}
+
+//the queued renderFrame of the last frames only schedules their paint
+void FrameReplay::onFinished()
+{
+	if (drainStartUs_ == 0)
+		drainStartUs_ = NowUs();
+	bool pending = false;
+	for (auto iter = widgets_.begin(); iter != widgets_.end(); ++iter)
+		pending = pending || iter->second->HasPendingFrame();
+	if (pending && NowUs() - drainStartUs_ < REPLAY_DRAIN_MS * 1000) {
+		QTimer::singleShot(10, this, &FrameReplay::onFinished);
+		return;
+	}
+	if (pending)
+		replayLog(QString("tiles still unpainted after %1 ms").arg(REPLAY_DRAIN_MS));
+	Report();
+	emit finished();
+}
+
+void FrameReplay::Report()
+{
+	double seconds = elapsedUs_ > 0 ? elapsedUs_ / 1000000.0 : 1.0;
+	VideoTileTotals all;
+	replayLog(QString("%1 frames in %2 ms, speed %3").arg(frames_).arg(elapsedUs_ / 1000).arg(speed_));
+	for (auto iter = widgets_.begin(); iter != widgets_.end(); ++iter) {
+		VideoTileTotals totals = iter->second->TileTotals();
+		replayLog(QString("uid %1 received %2 rendered %3 dropped %4 render %5 fps").arg(iter->first)
+			.arg(totals.received).arg(totals.rendered).arg(totals.dropped).arg(totals.rendered / seconds, 0, 'f', 1));
+		replayLog(QString("uid %1 copy mean %2 ms p50 %3 p95 %4 p99 %5, upload mean %6 ms p50 %7 p95 %8 p99 %9").arg(iter->first)
+			.arg(totals.received ? totals.copyUs / 1000.0 / totals.received : 0.0, 0, 'f', 3)
+			.arg(totals.copyP50Ms).arg(totals.copyP95Ms).arg(totals.copyP99Ms)
+			.arg(totals.rendered ? totals.uploadUs / 1000.0 / totals.rendered : 0.0, 0, 'f', 3)
+			.arg(totals.uploadP50Ms).arg(totals.uploadP95Ms).arg(totals.uploadP99Ms));
+		all.received += totals.received;
+		all.rendered += totals.rendered;
+		all.dropped += totals.dropped;
+		all.copyUs += totals.copyUs;
+		all.uploadUs += totals.uploadUs;
+	}
+	replayLog(QString("all tiles received %1 rendered %2 dropped %3 copy %4 ms upload %5 ms").arg(all.received)
+		.arg(all.rendered).arg(all.dropped).arg(all.copyUs / 1000).arg(all.uploadUs / 1000));
+}
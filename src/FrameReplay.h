@@ -0,0 +1,48 @@
+#ifndef FRAMEREPLAY_H
+#define FRAMEREPLAY_H
+
+#include <QWidget>
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include "FrameCapture.h"
+
+class VideoTileView;
+
+// Replays a FrameCapture file without the sdk: every uid of the file gets
+// a VideoTileView, frames go through CopyVideoFrame and the tile renderer
+// at the recorded timing divided by speed (0 feeds as fast as possible).
+// Run by the frame_replay program (FrameReplayMain.cpp), which links
+// neither the sdk nor the windows libraries. Once the last frames are
+// painted the whole run statistics of every tile are printed to stdout:
+// frame counts, drops and copy / upload totals with percentiles.
+class FrameReplay : public QWidget
+{
+	Q_OBJECT
+public:
+	FrameReplay(QWidget* parent = nullptr);
+	~FrameReplay();
+	bool Open(const QString& path);
+	void Start(float speed);
+	void Stop();
+signals:
+	void finished();
+private slots:
+	void onFinished();
+private:
+	void Run();
+	void Report();
+
+	FrameCaptureReader reader_;
+	std::map<unsigned int, VideoTileView*> widgets_;
+	std::thread thread_;
+	std::atomic<bool> stop_;
+	float speed_ = 1.0f;
+	int frames_ = 0;
+	int64_t elapsedUs_ = 0;
+	//first onFinished, bounds the wait for the last paints
+	int64_t drainStartUs_ = 0;
+};
+
+#endif // FRAMEREPLAY_H
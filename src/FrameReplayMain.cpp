@@ -0,0 +1,30 @@
+#include "FrameReplay.h"
+
+#include <QApplication>
+#include <QStringList>
+#include <cstdio>
+
+//frame_replay <capture> [--speed <factor>], renders a capture file of the F7 recording
+//without the sdk; speed 0 is unthrottled, the report goes to stdout
+int main(int argc, char *argv[])
+{
+	QApplication a(argc, argv);
+	QStringList args = a.arguments();
+	if (args.size() < 2) {
+		fprintf(stderr, "usage: frame_replay <capture> [--speed <factor>]\n");
+		return 1;
+	}
+	float speed = 1.0f;
+	int speedArg = args.indexOf("--speed");
+	if (speedArg >= 0 && speedArg + 1 < args.size())
+		speed = args[speedArg + 1].toFloat();
+	FrameReplay replayer;
+	if (!replayer.Open(args[1])) {
+		fprintf(stderr, "replay: cannot read %s\n", args[1].toUtf8().constData());
+		return 1;
+	}
+	QObject::connect(&replayer, &FrameReplay::finished, &a, &QApplication::quit);
+	replayer.show();
+	replayer.Start(speed);
+	return a.exec();
+}
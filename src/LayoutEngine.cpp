@@ -0,0 +1,149 @@
+#include "LayoutEngine.h"
+
+static int ScaleMetric(int metric, float scale)
+{
+	return (int)(metric * scale);
+}
+
+void LayoutSpec::FixedSize(QWidget* widget, int width, int height)
+{
+	Item item;
+	item.kind = ITEM_FIXED_SIZE;
+	item.widget = widget;
+	item.metrics[0] = width;
+	item.metrics[1] = height;
+	items_.push_back(item);
+}
+
+void LayoutSpec::MaximumWidth(QWidget* widget, int width)
+{
+	Item item;
+	item.kind = ITEM_MAXIMUM_WIDTH;
+	item.widget = widget;
+	item.metrics[0] = width;
+	items_.push_back(item);
+}
+
+void LayoutSpec::Spacing(QLayout* layout, int spacing)
+{
+	Item item;
+	item.kind = ITEM_SPACING;
+	item.layout = layout;
+	item.metrics[0] = spacing;
+	items_.push_back(item);
+}
+
+void LayoutSpec::Margins(QLayout* layout, int left, int top, int right, int bottom)
+{
+	Item item;
+	item.kind = ITEM_MARGINS;
+	item.layout = layout;
+	item.metrics[0] = left;
+	item.metrics[1] = top;
+	item.metrics[2] = right;
+	item.metrics[3] = bottom;
+	items_.push_back(item);
+}
+
+void LayoutSpec::Margins(QLayout* layout, MarginsFunc margins)
+{
+	Item item;
+	item.kind = ITEM_MARGINS;
+	item.layout = layout;
+	item.margins = margins;
+	items_.push_back(item);
+}
+
+void LayoutSpec::Style(QWidget* widget, const QString& style, int metric1, int metric2)
+{
+	Item item;
+	item.kind = ITEM_STYLE;
+	item.widget = widget;
+	item.style = style;
+	item.metrics[0] = metric1;
+	item.metrics[1] = metric2;
+	items_.push_back(item);
+}
+
+void LayoutEngine::SetSpec(const LayoutSpec& spec)
+{
+	spec_ = spec;
+	cache_.clear();
+	applied_.clear();
+}
+
+int LayoutEngine::Apply(const LayoutContext& context)
+{
+	const std::vector<Value>& values = Compute(context);
+	bool all = applied_.size() != values.size();
+	if (all)
+		applied_.resize(values.size());
+	int changed = 0;
+	for (size_t i = 0; i < values.size(); ++i) {
+		if (!all && applied_[i] == values[i])
+			continue;
+		ApplyItem(spec_.items_[i], values[i]);
+		applied_[i] = values[i];
+		++changed;
+	}
+	return changed;
+}
+
+const std::vector<LayoutEngine::Value>& LayoutEngine::Compute(const LayoutContext& context)
+{
+	QString key = QString("%1,%2,%3,%4|%5|%6|%7").arg(context.screen.x()).arg(context.screen.y())
+		.arg(context.screen.width()).arg(context.screen.height())
+		.arg(context.scale, 0, 'f', 4).arg(context.max).arg(context.variant);
+	auto iter = cache_.find(key);
+	if (iter != cache_.end())
+		return iter.value();
+
+	float scale = context.scale;
+	std::vector<Value> values(spec_.items_.size());
+	for (size_t i = 0; i < spec_.items_.size(); ++i) {
+		const LayoutSpec::Item& item = spec_.items_[i];
+		Value& value = values[i];
+		switch (item.kind) {
+		case LayoutSpec::ITEM_FIXED_SIZE:
+			value.size = QSize(ScaleMetric(item.metrics[0], scale), ScaleMetric(item.metrics[1], scale));
+			break;
+		case LayoutSpec::ITEM_MAXIMUM_WIDTH:
+		case LayoutSpec::ITEM_SPACING:
+			value.spacing = ScaleMetric(item.metrics[0], scale);
+			break;
+		case LayoutSpec::ITEM_MARGINS:
+			if (item.margins)
+				value.margins = item.margins(context);
+			else
+				value.margins = QMargins(ScaleMetric(item.metrics[0], scale), ScaleMetric(item.metrics[1], scale),
+					ScaleMetric(item.metrics[2], scale), ScaleMetric(item.metrics[3], scale));
+			break;
+		case LayoutSpec::ITEM_STYLE:
+			value.style = item.style.arg(ScaleMetric(item.metrics[0], scale)).arg(ScaleMetric(item.metrics[1], scale));
+			break;
+		}
+	}
+	return cache_.insert(key, values).value();
+}
+
+void LayoutEngine::ApplyItem(const LayoutSpec::Item& item, const Value& value)
+{
+	switch (item.kind) {
+	case LayoutSpec::ITEM_FIXED_SIZE:
+		item.widget->setMinimumSize(value.size);
+		item.widget->setMaximumSize(value.size);
+		break;
+	case LayoutSpec::ITEM_MAXIMUM_WIDTH:
+		item.widget->setMaximumWidth(value.spacing);
+		break;
+	case LayoutSpec::ITEM_SPACING:
+		item.layout->setSpacing(value.spacing);
+		break;
+	case LayoutSpec::ITEM_MARGINS:
+		item.layout->setContentsMargins(value.margins);
+		break;
+	case LayoutSpec::ITEM_STYLE:
+		item.widget->setStyleSheet(value.style);
+		break;
+	}
+}
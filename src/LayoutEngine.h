@@ -0,0 +1,95 @@
+#ifndef LAYOUTENGINE_H
+#define LAYOUTENGINE_H
+
+#include <QHash>
+#include <QLayout>
+#include <QMargins>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QWidget>
+#include <functional>
+#include <vector>
+
+//inputs of one layout pass
+typedef struct tagLayoutContext
+{
+	//dialog rectangle, rcMainScreen of the dialog
+	QRect screen;
+	//base pixels (1920 wide screen) to widget pixels, initRate / rate
+	float scale = 1.0f;
+	bool max = true;
+	//dialog state the spec depends on, e.g. the number of video rows
+	int variant = 0;
+}LayoutContext;
+
+// Declarative geometry of a dialog in base pixels of a 1920 wide screen.
+// Metrics are scaled by LayoutContext::scale, derived values (centering,
+// right alignment) are computed from the context by a function.
+class LayoutSpec
+{
+public:
+	typedef std::function<QMargins(const LayoutContext&)> MarginsFunc;
+	//minimum and maximum size
+	void FixedSize(QWidget* widget, int width, int height);
+	void MaximumWidth(QWidget* widget, int width);
+	void Spacing(QLayout* layout, int spacing);
+	void Margins(QLayout* layout, int left, int top, int right, int bottom);
+	void Margins(QLayout* layout, MarginsFunc margins);
+	//%1 and %2 of style are replaced by the scaled metrics
+	void Style(QWidget* widget, const QString& style, int metric1, int metric2);
+private:
+	friend class LayoutEngine;
+	enum ITEM_KIND
+	{
+		ITEM_FIXED_SIZE = 0,
+		ITEM_MAXIMUM_WIDTH,
+		ITEM_SPACING,
+		ITEM_MARGINS,
+		ITEM_STYLE
+	};
+	struct Item
+	{
+		ITEM_KIND kind;
+		QWidget* widget = nullptr;
+		QLayout* layout = nullptr;
+		int metrics[4] = { 0, 0, 0, 0 };
+		QString style;
+		MarginsFunc margins;
+	};
+	std::vector<Item> items_;
+};
+
+// Computes every rectangle of a LayoutSpec in one pass, caches the result
+// per (screen, scale, max, variant) and only touches widgets whose value
+// differs from what was applied last.
+class LayoutEngine
+{
+public:
+	void SetSpec(const LayoutSpec& spec);
+	//returns the number of widgets and layouts that changed
+	int Apply(const LayoutContext& context);
+	//the widgets were changed outside of the engine, the next Apply sets everything
+	void Invalidate() { applied_.clear(); }
+private:
+	struct Value
+	{
+		QSize size;
+		QMargins margins;
+		int spacing = 0;
+		QString style;
+		bool operator==(const Value& other) const
+		{
+			return size == other.size && margins == other.margins
+				&& spacing == other.spacing && style == other.style;
+		}
+	};
+	const std::vector<Value>& Compute(const LayoutContext& context);
+	void ApplyItem(const LayoutSpec::Item& item, const Value& value);
+
+	LayoutSpec spec_;
+	QHash<QString, std::vector<Value> > cache_;
+	std::vector<Value> applied_;
+};
+
+#endif // LAYOUTENGINE_H
@@ -0,0 +1,155 @@
+#include "MediaPlayerController.h"
+#include "StartupTrace.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+MediaPlayerController::MediaPlayerController(QObject* parent)
+	: QObject(parent)
+{
+}
+
+int MediaPlayerController::Open(const QString& url, bool autoPlay)
+{
+	if (!player_ || url.isEmpty())
+		return -1;
+	bool stop = false;
+	{
+		QMutexLocker lock(&mutex_);
+		if (url == metrics_.url && (metrics_.stage == PLAYER_STAGE_OPENING
+			|| metrics_.stage == PLAYER_STAGE_OPENED || metrics_.stage == PLAYER_STAGE_PLAYING)) {
+			autoPlay_ = autoPlay_ || autoPlay;
+			if (!autoPlay || metrics_.stage != PLAYER_STAGE_OPENED)
+				return 0;
+			lock.unlock();
+			return Play();
+		}
+		stop = metrics_.stage != PLAYER_STAGE_IDLE;
+		//callbacks of the previous url are ignored from here
+		metrics_ = PlayerMetrics();
+	}
+	//not under mutex_, stop may wait for the sdk thread that takes it in OnStateChanged
+	if (stop)
+		player_->stop();
+	{
+		QMutexLocker lock(&mutex_);
+		metrics_.url = url;
+		metrics_.stage = PLAYER_STAGE_OPENING;
+		autoPlay_ = autoPlay;
+		openTimer_.start();
+	}
+
+	//the first frame is shown without probing the stream for metadata first
+	player_->setPlayerOption("enable_search_metadata", 0);
+	int ret = player_->open(url.toUtf8().constData(), 0);
+	qDebug() << "player open" << url << "auto play" << autoPlay << "ret" << ret;
+	if (ret != 0) {
+		QMutexLocker lock(&mutex_);
+		metrics_.stage = PLAYER_STAGE_FAILED;
+		metrics_.error = ret;
+	}
+	return ret;
+}
+
+int MediaPlayerController::Play()
+{
+	if (!player_)
+		return -1;
+	{
+		QMutexLocker lock(&mutex_);
+		if (metrics_.stage == PLAYER_STAGE_PLAYING)
+			return 0;
+		//played by OnStateChanged
+		if (metrics_.stage == PLAYER_STAGE_OPENING) {
+			autoPlay_ = true;
+			return 0;
+		}
+		if (metrics_.stage != PLAYER_STAGE_OPENED)
+			return -1;
+	}
+	return player_->play();
+}
+
+int MediaPlayerController::Stop()
+{
+	if (!player_)
+		return -1;
+	{
+		QMutexLocker lock(&mutex_);
+		if (metrics_.stage != PLAYER_STAGE_IDLE)
+			qDebug() << "player stop" << metrics_.url << "open" << metrics_.openMs << "ms, play" << metrics_.playMs
+				<< "ms, stalls" << metrics_.stalls;
+		metrics_.stage = PLAYER_STAGE_IDLE;
+		autoPlay_ = false;
+	}
+	return player_->stop();
+}
+
+int MediaPlayerController::Pause(bool pause)
+{
+	if (!player_)
+		return -1;
+	return pause ? player_->pause() : player_->resume();
+}
+
+bool MediaPlayerController::IsOpened()
+{
+	QMutexLocker lock(&mutex_);
+	return metrics_.stage == PLAYER_STAGE_OPENED || metrics_.stage == PLAYER_STAGE_PLAYING;
+}
+
+PlayerMetrics MediaPlayerController::Metrics()
+{
+	QMutexLocker lock(&mutex_);
+	return metrics_;
+}
+
+void MediaPlayerController::OnStateChanged(agora::media::base::MEDIA_PLAYER_STATE state, agora::media::base::MEDIA_PLAYER_ERROR ec)
+{
+	QMutexLocker lock(&mutex_);
+	if (metrics_.stage == PLAYER_STAGE_IDLE)
+		return;
+	if (ec != agora::media::base::PLAYER_ERROR_NONE || state == agora::media::base::PLAYER_STATE_FAILED) {
+		metrics_.stage = PLAYER_STAGE_FAILED;
+		metrics_.error = ec;
+		qDebug() << "player failed" << metrics_.url << ec << "after" << openTimer_.elapsed() << "ms";
+	}
+	else if (state == agora::media::base::PLAYER_STATE_OPEN_COMPLETED) {
+		metrics_.stage = PLAYER_STAGE_OPENED;
+		metrics_.openMs = openTimer_.elapsed();
+		qDebug() << "player opened" << metrics_.url << metrics_.openMs << "ms";
+		//player calls are not made on the sdk callback thread
+		if (autoPlay_)
+			QMetaObject::invokeMethod(this, [this]() { Play(); }, Qt::QueuedConnection);
+	}
+	else if (state == agora::media::base::PLAYER_STATE_PLAYING) {
+		metrics_.stage = PLAYER_STAGE_PLAYING;
+		if (metrics_.playMs < 0) {
+			metrics_.playMs = openTimer_.elapsed();
+			qDebug() << "player playing" << metrics_.url << metrics_.playMs << "ms after open, buffer"
+				<< metrics_.bufferMs << "ms";
+			startupMark("media player playing");
+		}
+	}
+}
+
+void MediaPlayerController::OnBufferUpdated(int64_t playCachedBuffer)
+{
+	QMutexLocker lock(&mutex_);
+	metrics_.bufferMs = playCachedBuffer;
+}
+
+void MediaPlayerController::OnPositionChanged(int64_t position)
+{
+	QMutexLocker lock(&mutex_);
+	metrics_.positionMs = position;
+}
+
+void MediaPlayerController::OnPlayerEvent(agora::media::base::MEDIA_PLAYER_EVENT eventCode)
+{
+	QMutexLocker lock(&mutex_);
+	if (eventCode == agora::media::base::PLAYER_EVENT_BUFFER_LOW && metrics_.stage == PLAYER_STAGE_PLAYING) {
+		++metrics_.stalls;
+		qDebug() << "player buffer low at" << metrics_.positionMs << "ms, buffer" << metrics_.bufferMs << "ms";
+	}
+}
@@ -0,0 +1,67 @@
+#ifndef MEDIAPLAYERCONTROLLER_H
+#define MEDIAPLAYERCONTROLLER_H
+
+#include <IAgoraMediaPlayer.h>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+
+enum PLAYER_STAGE
+{
+	PLAYER_STAGE_IDLE = 0,
+	PLAYER_STAGE_OPENING,
+	PLAYER_STAGE_OPENED,
+	PLAYER_STAGE_PLAYING,
+	PLAYER_STAGE_FAILED
+};
+
+typedef struct tagPlayerMetrics
+{
+	QString url;
+	int stage = PLAYER_STAGE_IDLE;
+	//ms from open, -1 until reached
+	qint64 openMs = -1;
+	qint64 playMs = -1;
+	//cached ahead of the play position
+	qint64 bufferMs = 0;
+	qint64 positionMs = 0;
+	//buffer ran low while playing
+	int stalls = 0;
+	int error = 0;
+}PlayerMetrics;
+
+// Media player behind video source 2.
+// The url is opened at login, long before the room dialog shows, and with
+// autoPlay it plays as soon as it is open, so video source 2 publishes
+// from the start of the class. The dialogs only attach to it. Player
+// callbacks arrive on the sdk thread, the rest is called on the GUI thread.
+class MediaPlayerController : public QObject
+{
+	Q_OBJECT
+public:
+	MediaPlayerController(QObject* parent = nullptr);
+	void SetPlayer(agora::agora_refptr<agora::rtc::IMediaPlayer> player) { player_ = player; }
+	//a url already opening or open is kept, only autoPlay is updated
+	int Open(const QString& url, bool autoPlay);
+	int Play();
+	int Stop();
+	int Pause(bool pause);
+	//open or playing, the dialogs show it without waiting for openPlayerComplete
+	bool IsOpened();
+	PlayerMetrics Metrics();
+
+	void OnStateChanged(agora::media::base::MEDIA_PLAYER_STATE state, agora::media::base::MEDIA_PLAYER_ERROR ec);
+	void OnBufferUpdated(int64_t playCachedBuffer);
+	void OnPositionChanged(int64_t position);
+	void OnPlayerEvent(agora::media::base::MEDIA_PLAYER_EVENT eventCode);
+private:
+	agora::agora_refptr<agora::rtc::IMediaPlayer> player_;
+	QMutex mutex_;
+	PlayerMetrics metrics_;
+	bool autoPlay_ = false;
+	QElapsedTimer openTimer_;
+};
+
+#endif // MEDIAPLAYERCONTROLLER_H
@@ -0,0 +1,226 @@
+#include "RenderCheck.h"
+#include "video_render_opengl.h"
+
+#include <QDir>
+#include <QImage>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//largest per channel difference accepted against a golden image
+#define RENDER_CHECK_TOLERANCE 2
+
+//the reason of a failing run must reach the ctest log
+static void checkLog(const QString& text)
+{
+	fprintf(stderr, "render check: %s\n", text.toUtf8().constData());
+	fflush(stderr);
+}
+
+//rgb in [0, 1] to yuv bytes, the inverse of yuvToRgbCoefficients
+static void RgbToYuv(const float rgb[3], const VideoColorInfo& color, uint8_t yuv[3])
+{
+	float kr = color.matrix == VIDEO_COLOR_BT709 ? 0.2126f : 0.299f;
+	float kb = color.matrix == VIDEO_COLOR_BT709 ? 0.0722f : 0.114f;
+	float y = kr * rgb[0] + (1.0f - kr - kb) * rgb[1] + kb * rgb[2];
+	float pb = (rgb[2] - y) / (2.0f * (1.0f - kb));
+	float pr = (rgb[0] - y) / (2.0f * (1.0f - kr));
+	float values[3] = { y * 255.0f, 128.0f + pb * 255.0f, 128.0f + pr * 255.0f };
+	if (!color.fullRange) {
+		values[0] = 16.0f + y * 219.0f;
+		values[1] = 128.0f + pb * 224.0f;
+		values[2] = 128.0f + pr * 224.0f;
+	}
+	for (int i = 0; i < 3; ++i)
+		yuv[i] = (uint8_t)(std::min)((std::max)((int)(values[i] + 0.5f), 0), 255);
+}
+
+//four distinct quadrants encoded with the given color info, any rotation, mirror
+//or matrix error changes a color
+static void FillPattern(int width, int height, const VideoColorInfo& color, std::vector<uint8_t>& planes, agora::media::base::VideoFrame& frame)
+{
+	static const float rgb[4][3] = {
+		{ 1, 0, 0 },	//red, top left
+		{ 0, 1, 0 },	//green, top right
+		{ 0, 0, 1 },	//blue, bottom left
+		{ 1, 1, 1 }		//white, bottom right
+	};
+	uint8_t colors[4][3];
+	for (int i = 0; i < 4; ++i)
+		RgbToYuv(rgb[i], color, colors[i]);
+	int uvWidth = chromaSize(width);
+	int uvHeight = chromaSize(height);
+	size_t luma = (size_t)width * height;
+	size_t chroma = (size_t)uvWidth * uvHeight;
+	planes.resize(luma + 2 * chroma);
+	frame.type = agora::media::base::VIDEO_PIXEL_I420;
+	frame.width = width;
+	frame.height = height;
+	frame.yStride = width;
+	frame.uStride = uvWidth;
+	frame.vStride = uvWidth;
+	frame.yBuffer = planes.data();
+	frame.uBuffer = planes.data() + luma;
+	frame.vBuffer = planes.data() + luma + chroma;
+	frame.rotation = 0;
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x)
+			frame.yBuffer[y * width + x] = colors[(y * 2 / height) * 2 + x * 2 / width][0];
+	}
+	for (int y = 0; y < uvHeight; ++y) {
+		for (int x = 0; x < uvWidth; ++x) {
+			int quadrant = (y * 2 / uvHeight) * 2 + x * 2 / uvWidth;
+			frame.uBuffer[y * uvWidth + x] = colors[quadrant][1];
+			frame.vBuffer[y * uvWidth + x] = colors[quadrant][2];
+		}
+	}
+}
+
+//distance of each channel to the range of the golden's 3x3 neighbourhood,
+//so edges a GPU rasterizes or filters less than a pixel apart still match
+static int MaxDifference(const QImage& image, const QImage& golden)
+{
+	if (image.size() != golden.size())
+		return 256;
+	int width = golden.width();
+	int height = golden.height();
+	int diff = 0;
+	for (int y = 0; y < height; ++y) {
+		const uint8_t* row = image.constScanLine(y);
+		for (int x = 0; x < width * 4; ++x) {
+			int low = 255;
+			int high = 0;
+			for (int ny = (std::max)(y - 1, 0); ny <= (std::min)(y + 1, height - 1); ++ny) {
+				const uint8_t* goldenRow = golden.constScanLine(ny);
+				for (int nx = (std::max)(x - 4, x % 4); nx <= (std::min)(x + 4, width * 4 - 1); nx += 4) {
+					low = (std::min)(low, (int)goldenRow[nx]);
+					high = (std::max)(high, (int)goldenRow[nx]);
+				}
+			}
+			diff = (std::max)(diff, (std::max)(low - row[x], row[x] - high));
+		}
+	}
+	return diff;
+}
+
+//compares with the golden of the same name, or replaces it when update is set; false on a failure
+static bool CheckImage(const QImage& image, const QString& name, bool update)
+{
+	if (update) {
+		if (!image.save(name)) {
+			checkLog(QString("cannot write %1").arg(name));
+			return false;
+		}
+		return true;
+	}
+	QImage golden(name);
+	if (golden.isNull()) {
+		checkLog(QString("missing %1").arg(name));
+		return false;
+	}
+	int diff = MaxDifference(image, golden.convertToFormat(QImage::Format_RGBA8888));
+	if (diff > RENDER_CHECK_TOLERANCE) {
+		checkLog(QString("mismatch %1, max difference %2").arg(name).arg(diff));
+		image.save(name + ".actual.png");
+		return false;
+	}
+	return true;
+}
+
+int runRenderCheck(const QString& directory, bool update)
+{
+	QOpenGLContext context;
+	if (!context.create()) {
+		checkLog("no GL context");
+		return RENDER_CHECK_NO_GL;
+	}
+	QOffscreenSurface surface;
+	surface.setFormat(context.format());
+	surface.create();
+	if (!context.makeCurrent(&surface)) {
+		checkLog("cannot make the context current");
+		return RENDER_CHECK_NO_GL;
+	}
+	if (update)
+		QDir().mkpath(directory);
+
+	static const int frames[][2] = { { 320, 180 }, { 180, 320 }, { 161, 91 } };
+	static const int targets[][2] = { { 160, 160 }, { 320, 180 }, { 180, 320 } };
+	static const int modes[] = { 1, 2, 3 };
+	static const int rotations[] = { 0, 90, 180, 270 };
+
+	//one renderer for every case, so the cached draw plan must follow each change
+	VideoRendererOpenGL renderer(targets[0][0], targets[0][1]);
+	renderer.initialize(targets[0][0], targets[0][1]);
+	renderer.setRenderQuality(RENDER_QUALITY_LINEAR);
+	renderer.setColorInfo(VideoColorInfo());
+
+	int cases = 0;
+	int failures = 0;
+	std::vector<uint8_t> planes;
+	for (const auto& frameSize : frames) {
+		agora::media::base::VideoFrame frame;
+		FillPattern(frameSize[0], frameSize[1], VideoColorInfo(), planes, frame);
+		for (const auto& target : targets) {
+			QOpenGLFramebufferObject fbo(target[0], target[1]);
+			fbo.bind();
+			renderer.setSize(target[0], target[1]);
+			for (int mode : modes) {
+				for (int rotation : rotations) {
+					for (int mirrored = 0; mirrored < 2; ++mirrored) {
+						renderer.setRenderMode(mode);
+						renderer.setFrameInfo(rotation, mirrored != 0);
+						renderer.renderFrame(frame);
+						context.functions()->glFinish();
+						QImage image = fbo.toImage().convertToFormat(QImage::Format_RGBA8888);
+
+						QString name = QString("%1/%2x%3_%4x%5_mode%6_rot%7%8.png").arg(directory)
+							.arg(frameSize[0]).arg(frameSize[1]).arg(target[0]).arg(target[1])
+							.arg(mode).arg(rotation).arg(mirrored ? "_mirror" : "");
+						++cases;
+						if (!CheckImage(image, name, update))
+							++failures;
+					}
+				}
+			}
+			fbo.release();
+		}
+	}
+
+	//the other matrices and ranges, the pattern is encoded with each so the goldens
+	//show the same four colors as the BT.601 limited ones
+	static const int colorMatrices[] = { VIDEO_COLOR_BT601, VIDEO_COLOR_BT709, VIDEO_COLOR_BT709 };
+	static const bool colorFullRanges[] = { true, false, true };
+	for (int i = 0; i < 3; ++i) {
+		VideoColorInfo color;
+		color.matrix = colorMatrices[i];
+		color.fullRange = colorFullRanges[i];
+		agora::media::base::VideoFrame frame;
+		FillPattern(frames[0][0], frames[0][1], color, planes, frame);
+		renderer.setColorInfo(color);
+		for (const auto& target : targets) {
+			QOpenGLFramebufferObject fbo(target[0], target[1]);
+			fbo.bind();
+			renderer.setSize(target[0], target[1]);
+			renderer.setRenderMode(2);
+			renderer.setFrameInfo(0, false);
+			renderer.renderFrame(frame);
+			context.functions()->glFinish();
+			QImage image = fbo.toImage().convertToFormat(QImage::Format_RGBA8888);
+			QString name = QString("%1/%2x%3_%4x%5_mode2_rot0_%6%7.png").arg(directory)
+				.arg(frames[0][0]).arg(frames[0][1]).arg(target[0]).arg(target[1])
+				.arg(color.matrix == VIDEO_COLOR_BT709 ? "bt709" : "bt601").arg(color.fullRange ? "_full" : "");
+			++cases;
+			if (!CheckImage(image, name, update))
+				++failures;
+			fbo.release();
+		}
+	}
+	//the renderer releases its GL objects while the context is still current
+	checkLog(QString("%1 cases, %2 failed").arg(cases).arg(failures));
+	return failures ? RENDER_CHECK_FAILED : RENDER_CHECK_PASSED;
+}
@@ -0,0 +1,20 @@
+#ifndef RENDERCHECK_H
+#define RENDERCHECK_H
+
+#include <QString>
+
+//exit codes of render_check
+#define RENDER_CHECK_PASSED 0
+#define RENDER_CHECK_FAILED 1
+#define RENDER_CHECK_NO_GL 2
+
+// Golden image check of VideoRendererOpenGL, the render_check program
+// (RenderCheckMain.cpp) run by ctest against tests/render_check.
+// Synthetic YUV patterns are rendered into an offscreen framebuffer for every
+// render mode, rotation, mirroring and target shape, and for the BT.709 and
+// full range color infos, and compared with <dir>/<case>.png. --update
+// rewrites them; goldens are made on a reference GL (Mesa llvmpipe) and looked
+// at before they are committed. The reason of a failure is printed to stderr.
+int runRenderCheck(const QString& directory, bool update);
+
+#endif // RENDERCHECK_H
@@ -0,0 +1,17 @@
+#include "RenderCheck.h"
+
+#include <QGuiApplication>
+#include <QStringList>
+#include <cstdio>
+
+//render_check <golden dir> [--update], built without the sdk so ctest can run it on any machine with GL
+int main(int argc, char *argv[])
+{
+	QGuiApplication a(argc, argv);
+	QStringList args = a.arguments();
+	if (args.size() < 2) {
+		fprintf(stderr, "usage: render_check <golden dir> [--update]\n");
+		return RENDER_CHECK_FAILED;
+	}
+	return runRenderCheck(args[1], args.contains("--update"));
+}
@@ -0,0 +1,61 @@
+#include "SettingOptionRow.h"
+
+SettingOptionRow::SettingOptionRow(const QString& name, QVBoxLayout* parentLayout, QWidget* parent)
+	: QObject(parent)
+{
+	rowLayout_ = new QVBoxLayout();
+	itemLayout_ = new QHBoxLayout();
+	QHBoxLayout* stepLayout = new QHBoxLayout();
+	stepLayout->setSpacing(0);
+
+	name_ = new QLabel(name, parent);
+	pre_ = new QPushButton(parent);
+	value_ = new QLabel(parent);
+	value_->setAlignment(Qt::AlignCenter);
+	next_ = new QPushButton(parent);
+	line_ = new QFrame(parent);
+	line_->setFrameShape(QFrame::HLine);
+	pre_->setStyleSheet("QPushButton{border:none;"
+		"border-image: url(:/AgoraCourse/Resources/dualTeacher/icon-backward.png);}");
+	next_->setStyleSheet("QPushButton{border:none;"
+		"border-image: url(:/AgoraCourse/Resources/dualTeacher/icon-forward.png);}");
+	line_->setStyleSheet("QFrame{border: none;background-color: rgba(122, 120, 120, 1);}");
+
+	stepLayout->addWidget(pre_);
+	stepLayout->addWidget(value_);
+	stepLayout->addWidget(next_);
+	itemLayout_->addWidget(name_);
+	itemLayout_->addLayout(stepLayout);
+	rowLayout_->addLayout(itemLayout_);
+	rowLayout_->addWidget(line_);
+	parentLayout->addLayout(rowLayout_);
+
+	connect(pre_, &QPushButton::clicked, this, &SettingOptionRow::previous);
+	connect(next_, &QPushButton::clicked, this, &SettingOptionRow::next);
+}
+
+void SettingOptionRow::SetLayout(const SettingRowMetrics& metrics, float rate)
+{
+	rowLayout_->setSpacing(metrics.rowSpacing / rate);
+	itemLayout_->setSpacing(metrics.spacing / rate);
+	itemLayout_->setContentsMargins(metrics.leftMargin / rate, 0, 0, 0);
+	QSize label(metrics.labelW / rate, metrics.labelH / rate);
+	QSize button(metrics.buttonW / rate, metrics.buttonW / rate);
+	QSize value(metrics.valueW / rate, metrics.labelH / rate);
+	name_->setFixedSize(label);
+	pre_->setFixedSize(button);
+	next_->setFixedSize(button);
+	value_->setFixedSize(value);
+	line_->setFixedSize(QSize(metrics.lineW / rate, 1));
+
+	QString style = QString::fromUtf8("QLabel{\n"
+		"font-size: %1px;\n"
+		"font-family: PingFangSC-Medium, PingFang SC;\n"
+		"font-weight: 500;\n"
+		"color: #333333;\n"
+		"line-height: %2px;\n"
+		"background-color: rgba(255, 255, 255,0);\n"
+		"}").arg((int)(metrics.fontSize / rate)).arg((int)(metrics.lineHeight / rate));
+	name_->setStyleSheet(style);
+	value_->setStyleSheet(style);
+}
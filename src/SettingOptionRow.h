@@ -0,0 +1,49 @@
+#ifndef SETTINGOPTIONROW_H
+#define SETTINGOPTIONROW_H
+
+#include <QFrame>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QObject>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+//sizes of a row already scaled by the dialog initRate, divided by its rate when applied
+typedef struct tagSettingRowMetrics
+{
+	int leftMargin = 0;
+	int labelW = 104;
+	int labelH = 37;
+	int buttonW = 52;
+	int valueW = 153;
+	int spacing = 184;
+	int rowSpacing = 13;
+	int lineW = 630;
+	int fontSize = 26;
+	int lineHeight = 37;
+}SettingRowMetrics;
+
+// "name  < value >" row of a settings page, the layout of the enable rows
+// of the .ui files, built in code for options added after them.
+class SettingOptionRow : public QObject
+{
+	Q_OBJECT
+public:
+	SettingOptionRow(const QString& name, QVBoxLayout* parentLayout, QWidget* parent);
+	void SetValue(const QString& text) { value_->setText(text); }
+	void SetToolTip(const QString& tip) { value_->setToolTip(tip); }
+	void SetLayout(const SettingRowMetrics& metrics, float rate);
+signals:
+	void previous();
+	void next();
+private:
+	QLabel* name_ = nullptr;
+	QPushButton* pre_ = nullptr;
+	QLabel* value_ = nullptr;
+	QPushButton* next_ = nullptr;
+	QFrame* line_ = nullptr;
+	QVBoxLayout* rowLayout_ = nullptr;
+	QHBoxLayout* itemLayout_ = nullptr;
+};
+
+#endif // SETTINGOPTIONROW_H
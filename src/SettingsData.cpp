@@ -8,7 +8,7 @@ CSettingsData* CSettingsData::GetSettingsData()
 CSettingsData setting;
 
 CSettingsData::CSettingsData()
-	:  encoder_type(ENCODER_SOFTWARE)
+	:  encoder_type(ENCODER_DEFAULT)
 	, resolution_type(VIDEO_RESOLUTION_480P)
 	, microphoneId(QString(""))
 	, speakerId(QString(""))
@@ -19,6 +19,8 @@ CSettingsData::CSettingsData()
 {
 	userInfo.uid = 0;
 	userInfo2.uid = 0;
+	userInfo3.uid = 0;
+	userInfo4.uid = 0;
 	Resolution  res = { 1280, 720 };
 	resolution.push_back(res);
 	/*resolution[0].width = 1280;
@@ -1,6 +1,7 @@
 #pragma once
 #include <unordered_map>
 #include <IAgoraRtcEngine.h>
+#include "video_frame_copy.h"
 #include <QString>
 #include <QRect>
 #include <QVector>
@@ -33,6 +34,8 @@ enum VIDEO_RESOLUTION_TYPE
 };
 
 enum ENCODER_TYPE{
+	//che.hardware_encoding is left to the sdk
+	ENCODER_DEFAULT = -1,
 	ENCODER_SOFTWARE = 0,
 	ENCODER_NVIDIA,
 	ENCODER_INTEL
@@ -77,10 +80,20 @@ public:
 	QString microphoneId;
 	QString speakerId;
 	QString videoSource1Id;
+	QString videoSource3Id;
 	int microphoneVolume;
 	int speakerVolume;
 	bool enabledVideoSource1 = true;
 	bool enabledVideoSource2 = false;
+	bool enabledVideoSource3 = false; //document camera
+	bool enabledScreenShare = false;
+	//camera encoder steps down under cpu or uplink pressure, see EncoderController; video settings
+	bool adaptiveEncoder = false;
+	//thumbnails of the rendered uids for monitoring, see AgoraRtcEngine::SetSnapshotMonitor; video settings
+	bool snapshotMonitor = false;
+	//YUV matrix and range of the teacher and document camera frames; video settings
+	VideoColorInfo videoSource1Color;
+	VideoColorInfo videoSource3Color;
 	bool agcOn = true;
 	bool aecOn = true;
 	bool ansOn = true;
@@ -88,10 +101,14 @@ public:
 	float rate = 1.0f;
 	UserInfo userInfo;
 	UserInfo userInfo2;
+	UserInfo userInfo3;
+	UserInfo userInfo4;
 	QString className;
 	QString videoSource2Url = "";// "rtmp://ongoing.pull-rtmp.bsc.agoramde.agoraio.cn/live/agora123";//"rtmp://ongoing.pull-rtmp.bsc.agoramde.agoraio.cn/live/test1234";
 	bool bExtend = false;
 	DPI_TYPE dpiType = DPI_1080;
+	//tile grid of the video room
+	STUDENT_1VN_TYPE studentType = STUDENT_1V4;
 private:
 	
 };
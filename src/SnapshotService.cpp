@@ -0,0 +1,97 @@
+#include "SnapshotService.h"
+#include "AgoraRtcEngine.h"
+
+#include <chrono>
+
+static int64_t NowMs()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SnapshotService::SnapshotService(QObject* parent)
+	: QObject(parent)
+{
+}
+
+SnapshotService::~SnapshotService()
+{
+	Stop();
+}
+
+void SnapshotService::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		running_ = false;
+		jobs_.clear();
+	}
+	cond_.notify_all();
+	if (thread_.joinable())
+		thread_.join();
+}
+
+void SnapshotService::SetPeriodic(int intervalMs, int width, int height)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		periodicMs_ = (width > 0 && height > 0) ? intervalMs : 0;
+		periodicWidth_ = width;
+		periodicHeight_ = height;
+		nextPeriodic_ = NowMs();
+		if (periodicMs_ > 0)
+			StartLocked();
+		else
+			jobs_.clear();
+	}
+	cond_.notify_one();
+}
+
+//the worker starts when the snapshots are turned on
+void SnapshotService::StartLocked()
+{
+	if (running_)
+		return;
+	if (thread_.joinable())
+		thread_.join();
+	running_ = true;
+	thread_ = std::thread(&SnapshotService::Run, this);
+}
+
+void SnapshotService::Run()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (running_) {
+		int64_t now = NowMs();
+		if (periodicMs_ > 0 && now >= nextPeriodic_) {
+			nextPeriodic_ = now + periodicMs_;
+			int width = periodicWidth_;
+			int height = periodicHeight_;
+			lock.unlock();
+			QList<unsigned int> uids = AgoraRtcEngine::GetAgoraRtcEngine()->RenderedUids();
+			lock.lock();
+			//a round still pending when the next one is due is replaced
+			jobs_.clear();
+			for (int i = 0; i < uids.size(); ++i) {
+				if (uids[i] != 0)
+					jobs_.push_back({ uids[i], width, height });
+			}
+		}
+		if (jobs_.empty()) {
+			if (periodicMs_ > 0)
+				cond_.wait_for(lock, std::chrono::milliseconds(nextPeriodic_ - now));
+			else
+				cond_.wait(lock);
+			continue;
+		}
+
+		Job job = jobs_.front();
+		jobs_.pop_front();
+		lock.unlock();
+		QImage image;
+		//tiles without a frame yet are skipped silently
+		if (AgoraRtcEngine::GetAgoraRtcEngine()->GrabVideoFrame(job.uid, job.width, job.height, image))
+			emit snapshotReady(job.uid, image);
+		lock.lock();
+	}
+}
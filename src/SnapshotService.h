@@ -0,0 +1,53 @@
+#ifndef SNAPSHOTSERVICE_H
+#define SNAPSHOTSERVICE_H
+
+#include <QImage>
+#include <QObject>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+//monitoring thumbnails, see AgoraRtcEngine::SetSnapshotMonitor
+#define SNAPSHOT_MONITOR_MS 5000
+#define SNAPSHOT_MONITOR_WIDTH 160
+#define SNAPSHOT_MONITOR_HEIGHT 90
+
+// Small RGBA images of the frames the tiles already hold, taken of every
+// rendered uid each interval for monitoring. Frames are cropped, scaled and
+// converted on the cpu by a worker thread (VideoWidget::GrabFrame), the GUI
+// thread is not involved.
+class SnapshotService : public QObject
+{
+	Q_OBJECT
+public:
+	SnapshotService(QObject* parent = nullptr);
+	~SnapshotService();
+	void Stop();
+	//snapshots of every rendered uid each intervalMs, 0 turns it off
+	void SetPeriodic(int intervalMs, int width, int height);
+signals:
+	//emitted on the worker thread
+	void snapshotReady(unsigned int uid, QImage image);
+private:
+	struct Job
+	{
+		unsigned int uid;
+		int width;
+		int height;
+	};
+	void StartLocked();
+	void Run();
+
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	bool running_ = false;
+	std::deque<Job> jobs_;
+	int periodicMs_ = 0;
+	int periodicWidth_ = 0;
+	int periodicHeight_ = 0;
+	int64_t nextPeriodic_ = 0;
+};
+
+#endif // SNAPSHOTSERVICE_H
@@ -0,0 +1,42 @@
+#include "StartupTrace.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+
+static std::mutex g_startupMutex;
+static QElapsedTimer g_startupTimer;
+static int64_t g_lastMarkMs = 0;
+static FILE* g_startupFile = nullptr;
+
+//log/startup.log beside the application logs, one block per run
+static void openStartupFile()
+{
+	QString path = QDir::currentPath() + "/log";
+	if (!QDir().mkpath(path))
+		return;
+	path += "/startup.log";
+	g_startupFile = fopen(QDir::toNativeSeparators(path).toLocal8Bit().constData(), "a");
+	if (g_startupFile)
+		fprintf(g_startupFile, "run %s\n", QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss").toUtf8().constData());
+}
+
+void startupMark(const char* phase)
+{
+	std::lock_guard<std::mutex> lock(g_startupMutex);
+	if (!g_startupTimer.isValid()) {
+		g_startupTimer.start();
+		openStartupFile();
+	}
+	int64_t now = g_startupTimer.elapsed();
+	qDebug() << "startup" << phase << now << "ms (+" << (now - g_lastMarkMs) << "ms)";
+	if (g_startupFile) {
+		fprintf(g_startupFile, "startup %s %lld ms (+%lld ms)\n", phase, (long long)now, (long long)(now - g_lastMarkMs));
+		fflush(g_startupFile);
+	}
+	g_lastMarkMs = now;
+}
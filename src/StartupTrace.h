@@ -0,0 +1,10 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+// Cold start timing. Each phase is logged as
+// "startup <phase> <ms since the first mark> (+<ms since the previous mark>)",
+// the first mark is made in main. Any thread. The marks also go to
+// log/startup.log under the working directory, appended run after run.
+void startupMark(const char* phase);
+
+#endif // STARTUPTRACE_H
@@ -0,0 +1,187 @@
+#include "SubscriptionCoordinator.h"
+
+#include <QMutexLocker>
+
+SubscriptionCoordinator::SubscriptionCoordinator(VideoSourceRegistry* sources)
+	: sources_(sources)
+{
+}
+
+void SubscriptionCoordinator::ApplyJoinOptions(agora::rtc::ChannelMediaOptions& option) const
+{
+	//remote users are subscribed one by one on the owner connection
+	option.autoSubscribeAudio = false;
+	option.autoSubscribeVideo = false;
+}
+
+void SubscriptionCoordinator::OnSourceJoined(VideoSource* source)
+{
+	std::vector<Action> actions;
+	{
+		QMutexLocker lock(&mutex_);
+		joined_.insert(source->Kind());
+		seen_[source->Uid()].clear();
+		ChangeOwner(SelectOwner(), actions);
+	}
+	Execute(actions);
+}
+
+void SubscriptionCoordinator::OnSourceLeft(VideoSource* source)
+{
+	std::vector<Action> actions;
+	{
+		QMutexLocker lock(&mutex_);
+		joined_.erase(source->Kind());
+		seen_.erase(source->Uid());
+		//subscriptions of a connection end with it
+		if (owner_ == source)
+			owner_ = nullptr;
+		ChangeOwner(SelectOwner(), actions);
+		if (!owner_)
+			remoteUsers_.clear();
+	}
+	Execute(actions);
+}
+
+bool SubscriptionCoordinator::OnUserJoined(agora::rtc::uid_t localUid, agora::rtc::uid_t remoteUid)
+{
+	std::vector<Action> actions;
+	bool report = false;
+	{
+		QMutexLocker lock(&mutex_);
+		if (sources_->IsLocalUid(remoteUid))
+			return false;
+		seen_[localUid].insert(remoteUid);
+		if (!owner_ || owner_->Uid() != localUid)
+			return false;
+		Subscribe(owner_, remoteUid, actions);
+		report = remoteUsers_.insert(remoteUid).second;
+	}
+	Execute(actions);
+	return report;
+}
+
+bool SubscriptionCoordinator::OnUserOffline(agora::rtc::uid_t localUid, agora::rtc::uid_t remoteUid)
+{
+	QMutexLocker lock(&mutex_);
+	if (sources_->IsLocalUid(remoteUid))
+		return false;
+	auto iter = seen_.find(localUid);
+	if (iter != seen_.end())
+		iter->second.erase(remoteUid);
+	if (!owner_ || owner_->Uid() != localUid)
+		return false;
+	return remoteUsers_.erase(remoteUid) > 0;
+}
+
+bool SubscriptionCoordinator::IsOwner(agora::rtc::uid_t localUid)
+{
+	QMutexLocker lock(&mutex_);
+	return owner_ && owner_->Uid() == localUid;
+}
+
+VideoSource* SubscriptionCoordinator::Owner()
+{
+	QMutexLocker lock(&mutex_);
+	return owner_;
+}
+
+void SubscriptionCoordinator::SetRemoteVideoMuted(agora::rtc::uid_t remoteUid, bool mute)
+{
+	std::vector<Action> actions;
+	{
+		QMutexLocker lock(&mutex_);
+		if (mute)
+			mutedVideo_.insert(remoteUid);
+		else
+			mutedVideo_.erase(remoteUid);
+		if (owner_ && Seen(owner_->Uid(), remoteUid))
+			Subscribe(owner_, remoteUid, actions);
+	}
+	Execute(actions);
+}
+
+void SubscriptionCoordinator::SetRemoteAudioMuted(agora::rtc::uid_t remoteUid, bool mute)
+{
+	std::vector<Action> actions;
+	{
+		QMutexLocker lock(&mutex_);
+		if (mute)
+			mutedAudio_.insert(remoteUid);
+		else
+			mutedAudio_.erase(remoteUid);
+		if (owner_ && Seen(owner_->Uid(), remoteUid))
+			Subscribe(owner_, remoteUid, actions);
+	}
+	Execute(actions);
+}
+
+//first joined source in VIDEO_SOURCE_KIND order, the teacher camera when it is in the channel
+VideoSource* SubscriptionCoordinator::SelectOwner() const
+{
+	if (joined_.empty())
+		return nullptr;
+	return sources_->Get(*joined_.begin());
+}
+
+void SubscriptionCoordinator::ChangeOwner(VideoSource* owner, std::vector<Action>& actions)
+{
+	if (owner == owner_)
+		return;
+	VideoSource* previous = owner_;
+	owner_ = owner;
+
+	if (previous) {
+		auto users = seen_.find(previous->Uid());
+		if (users != seen_.end()) {
+			for (auto iter = users->second.begin(); iter != users->second.end(); ++iter)
+				Unsubscribe(previous, *iter, actions);
+		}
+	}
+	if (owner) {
+		//the rest are subscribed when the new owner reports them
+		auto users = seen_.find(owner->Uid());
+		if (users != seen_.end()) {
+			for (auto iter = users->second.begin(); iter != users->second.end(); ++iter)
+				Subscribe(owner, *iter, actions);
+		}
+	}
+}
+
+bool SubscriptionCoordinator::Seen(agora::rtc::uid_t localUid, agora::rtc::uid_t remoteUid) const
+{
+	auto iter = seen_.find(localUid);
+	return iter != seen_.end() && iter->second.count(remoteUid) > 0;
+}
+
+void SubscriptionCoordinator::Subscribe(VideoSource* source, agora::rtc::uid_t remoteUid, std::vector<Action>& actions) const
+{
+	Action action;
+	action.connection = source->Connection();
+	action.remoteUid = remoteUid;
+	action.muteAudio = mutedAudio_.count(remoteUid) > 0;
+	action.muteVideo = mutedVideo_.count(remoteUid) > 0;
+	actions.push_back(action);
+}
+
+void SubscriptionCoordinator::Unsubscribe(VideoSource* source, agora::rtc::uid_t remoteUid, std::vector<Action>& actions) const
+{
+	Action action;
+	action.connection = source->Connection();
+	action.remoteUid = remoteUid;
+	action.muteAudio = true;
+	action.muteVideo = true;
+	actions.push_back(action);
+}
+
+//sdk calls are made outside of mutex_
+void SubscriptionCoordinator::Execute(const std::vector<Action>& actions)
+{
+	if (!engine_)
+		return;
+	for (size_t i = 0; i < actions.size(); ++i) {
+		const Action& action = actions[i];
+		engine_->muteRemoteAudioStreamEx(action.remoteUid, action.muteAudio, action.connection);
+		engine_->muteRemoteVideoStreamEx(action.remoteUid, action.muteVideo, action.connection);
+	}
+}
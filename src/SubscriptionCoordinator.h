@@ -0,0 +1,67 @@
+#ifndef SUBSCRIPTIONCOORDINATOR_H
+#define SUBSCRIPTIONCOORDINATOR_H
+
+#include <IAgoraRtcEngineEx.h>
+
+#include <QMutex>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "VideoSource.h"
+
+// Decides which local connection downloads remote users.
+// Every VideoSource joins with auto subscribe disabled, so nothing is
+// downloaded before the coordinator asks for it. Exactly one joined
+// source (the owner, first of VIDEO_SOURCE_KIND order) subscribes each
+// remote uid explicitly; local uids are never subscribed on any of them.
+// Event methods are called on the sdk thread, the rest on the GUI thread.
+class SubscriptionCoordinator
+{
+public:
+	SubscriptionCoordinator(VideoSourceRegistry* sources);
+	void SetEngine(agora::rtc::IRtcEngineEx* engine) { engine_ = engine; }
+
+	//fill the join options of a source, auto subscribe stays off
+	void ApplyJoinOptions(agora::rtc::ChannelMediaOptions& option) const;
+
+	void OnSourceJoined(VideoSource* source);
+	void OnSourceLeft(VideoSource* source);
+	//return true when the event should be reported to the UI
+	bool OnUserJoined(agora::rtc::uid_t localUid, agora::rtc::uid_t remoteUid);
+	bool OnUserOffline(agora::rtc::uid_t localUid, agora::rtc::uid_t remoteUid);
+
+	bool IsOwner(agora::rtc::uid_t localUid);
+	VideoSource* Owner();
+	void SetRemoteVideoMuted(agora::rtc::uid_t remoteUid, bool mute);
+	void SetRemoteAudioMuted(agora::rtc::uid_t remoteUid, bool mute);
+private:
+	struct Action
+	{
+		agora::rtc::RtcConnection connection;
+		agora::rtc::uid_t remoteUid;
+		bool muteAudio;
+		bool muteVideo;
+	};
+	VideoSource* SelectOwner() const;
+	void ChangeOwner(VideoSource* owner, std::vector<Action>& actions);
+	//remoteUid was reported on the connection of localUid, without adding an entry to seen_
+	bool Seen(agora::rtc::uid_t localUid, agora::rtc::uid_t remoteUid) const;
+	void Subscribe(VideoSource* source, agora::rtc::uid_t remoteUid, std::vector<Action>& actions) const;
+	void Unsubscribe(VideoSource* source, agora::rtc::uid_t remoteUid, std::vector<Action>& actions) const;
+	void Execute(const std::vector<Action>& actions);
+
+	VideoSourceRegistry* sources_;
+	agora::rtc::IRtcEngineEx* engine_ = nullptr;
+	QMutex mutex_;
+	std::set<VIDEO_SOURCE_KIND> joined_;
+	VideoSource* owner_ = nullptr;
+	//remote uids seen by each local uid
+	std::map<agora::rtc::uid_t, std::set<agora::rtc::uid_t> > seen_;
+	//remote uids reported to the UI
+	std::set<agora::rtc::uid_t> remoteUsers_;
+	std::set<agora::rtc::uid_t> mutedAudio_;
+	std::set<agora::rtc::uid_t> mutedVideo_;
+};
+
+#endif // SUBSCRIPTIONCOORDINATOR_H
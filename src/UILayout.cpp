@@ -11,6 +11,8 @@
 #include "VideoWidget.h"
 #include "AgoraCourse.h"
 #include "AgoraRtcEngine.h"
+#include <QStyle>
+#include "StartupTrace.h"
 ///////////////////////////////////////////////////////////////
 //////////AgoraCourse
 ///////////////////////////////////////////////////////////////
@@ -266,6 +268,10 @@ void AgoraCourse::showEvent(QShowEvent* event)
 	setEditLayout();
 	setLoginButton();
 	setBottomLabel();
+	if (!shown_) {
+		shown_ = true;
+		startupMark("login dialog shown");
+	}
 }
 
 void AgoraCourse::on_settingsButton_clicked()
@@ -273,6 +279,9 @@ void AgoraCourse::on_settingsButton_clicked()
 	//设置对话框
 	QRect rc = this->screen()->availableGeometry();
 	if (!dlgSettings) {
+		//the settings pages enumerate devices through the engine
+		if (!WaitEngine())
+			return;
 		float r = bMax ? rate * 3 / 4 : rate;
 		float r2 = bMax ? rate2 * 3 / 4 : rate2;
 		
@@ -1254,6 +1263,10 @@ void DlgSettingVideo::setVideoSourceLayout()
 	ui.labelvideo2Info->setMinimumSize(QSize(videoInfoW / rate, videoInfoH / rate));
 	ui.widgetVideo1->setMaximumSize(QSize(videoWidgetW / rate, videoWidgetH / rate));
 	ui.widgetVideo1->setMinimumSize(QSize(videoWidgetW / rate, videoWidgetH / rate));
+	if (previewWidget_) {
+		previewWidget_->SetRate(rate);
+		previewWidget_->MaximizeWidget(videoWidgetW / rate, videoWidgetH / rate);
+	}
 	ui.widgetVideo2->setMaximumSize(QSize(videoWidgetW / rate, videoWidgetH / rate));
 	ui.widgetVideo2->setMinimumSize(QSize(videoWidgetW / rate, videoWidgetH / rate));
 	//右侧设置部分
@@ -1502,6 +1515,32 @@ void DlgSettingVideo::setVideoSourceLayout()
 		"                    }\n"
 		"                  ").arg(labelFontSize).arg(line_height).arg((int)(micSelectTextPadding / rate));
 	ui.btnVideoSource2->setStyleSheet(style);
+
+	encoderRow_->SetLayout(RowMetrics(), rate);
+	adaptiveRow_->SetLayout(RowMetrics(), rate);
+	documentCameraRow_->SetLayout(RowMetrics(), rate);
+	screenShareRow_->SetLayout(RowMetrics(), rate);
+	studentTypeRow_->SetLayout(RowMetrics(), rate);
+	snapshotRow_->SetLayout(RowMetrics(), rate);
+	recordingRow_->SetLayout(RowMetrics(), rate);
+	cameraColorRow_->SetLayout(RowMetrics(), rate);
+	documentColorRow_->SetLayout(RowMetrics(), rate);
+}
+
+SettingRowMetrics DlgSettingVideo::RowMetrics()
+{
+	SettingRowMetrics metrics;
+	metrics.leftMargin = horizontalLayout_video1_1LeftMargin;
+	metrics.labelW = labelInfoW;
+	metrics.labelH = labelInfoH;
+	metrics.buttonW = backForwardW;
+	metrics.valueW = resBtnW;
+	metrics.spacing = horizontalLayout_ResVideo1Space;
+	metrics.rowSpacing = verticalLayout_Video1Space;
+	metrics.lineW = lineW;
+	metrics.fontSize = fontSize;
+	metrics.lineHeight = lineHeight;
+	return metrics;
 }
 
 void DlgSettingVideo::setBottomLabel()
@@ -2420,23 +2459,9 @@ void DlgInfo::on_parentMax_slot(bool childMax)
 /////////////////////////////////////////////////////////////
 void DlgVideoRoom::InitDlg()
 {
-	//title
-	titleHeight = 67* initRate;
-	titleFontSize = 48* initRate;
-	titleTopMargin = 48* initRate;
-	titleBottomMargin = 20* initRate;
-	labTitleW = 192* initRate;
-	labTitleH = 67* initRate;
-
-	//video widget
+	//video widget, the rest of the geometry is in BuildLayoutSpec
 	videoW = 710* initRate;
 	videoH = 400* initRate;
-	videoSpace = 36* initRate;
-	videoMargin = 73* initRate;
-	pageBtnW = 52* initRate;
-	pageBtnH = 52* initRate;
-	midMargin = 98* initRate;
-	bottomTopMargin = 18* initRate;
 	if (setting.bExtend)
 		ui.settingsButton->hide();
 
@@ -2451,32 +2476,19 @@ void DlgVideoRoom::InitDlg()
 		"background-color: rgba(255, 255, 255, 0.7);}");
 	ui.horizontalLayoutWidget->setGeometry(rcMainScreen);
 	ui.horizontalLayoutWidget->setStyleSheet(style);
-	setTopButtonLayout();
-	setTitleLayout();
-	for (int i = 0; i < 4; ++i) {
-		videoWidget[i] = new VideoWidget(initRate, rate, ui.horizontalLayoutWidget);
-		videoWidget[i]->setObjectName(QString::fromUtf8("widget_%1").arg(i));
-		videoWidget[i]->setMinimumSize(QSize(int(videoW / rate), int(videoH / rate)));
-		videoWidget[i]->setMaximumSize(QSize(int(videoW / rate), int(videoH / rate)));
-		if (i < 2)
-			ui.horizontalLayout_Row1->addWidget(videoWidget[i]);
-		else
-			ui.horizontalLayoutRow2->addWidget(videoWidget[i]);
-	}
-	videoWidget[2]->hide();
-	videoWidget[3]->hide();
-
-	setOptionLayout();
-	setBottomLabel();
+	//tiles are children of the grid area, created by Tile and placed by ShowWidgets
+	gridWidget_ = new QWidget(ui.horizontalLayoutWidget);
+	gridWidget_->setObjectName(QString::fromUtf8("gridWidget"));
+	gridWidget_->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+	gridWidget_->installEventFilter(this);
+	ui.horizontalLayout_Row1->addWidget(gridWidget_);
+	grid_.SetMode(setting.studentType);
+	widgetsCount = grid_.Capacity();
+	tiles_.SetCreateFunc([this]() { return CreateTile(); });
+
+	BuildLayoutSpec();
+	ApplyLayout();
 	showPage(false);
-	for (int i = 0; i < 4; ++i) {
-		connect(videoWidget[i], &VideoWidget::fullScreenSignal,
-			this, &DlgVideoRoom::on_fullScreen);
-		connect(videoWidget[i], &VideoWidget::muteVideoSignal,
-			this, &DlgVideoRoom::on_muteVideo);
-		connect(videoWidget[i], &VideoWidget::muteAudioSignal,
-			this, &DlgVideoRoom::on_muteAudio);
-	}
 
 	connect(rtcEngine, &AgoraRtcEngine::userJoined,
 		this, &DlgVideoRoom::onUserJoined);
@@ -2487,49 +2499,84 @@ void DlgVideoRoom::InitDlg()
 		this, &DlgVideoRoom::onStreamMessage);
 }
 
-
-void DlgVideoRoom::setTopButtonLayout()
+VideoWidget* DlgVideoRoom::CreateTile()
 {
-	float w = topButtonWidth / rate;
-	float buttonLeftMargin = rcMainScreen.width() - (w * 4 + 3 * topButtonSpace / rate);
-	ui.closeButton->setMaximumSize(w, w);
-	ui.closeButton->setMinimumSize(w, w);
-
-	ui.minButton->setMaximumSize(w, w);
-	ui.minButton->setMinimumSize(w, w);
-
-	ui.maxButton->setMaximumSize(w, w);
-	ui.maxButton->setMinimumSize(w, w);
-
-	ui.settingsButton->setMaximumSize(w, w);
-	ui.settingsButton->setMinimumSize(w, w);
-	//layout
-	ui.horizontalLayout_titleButton->setSpacing(topButtonSpace / rate);
-	ui.horizontalLayout_titleButton->setContentsMargins(buttonLeftMargin, topButtonTopMargin / rate, topButtonRightMargin / rate, 0);
+	VideoWidget* tile = new VideoWidget(initRate, rate, gridWidget_);
+	tile->setObjectName(QString::fromUtf8("widget_%1").arg(tiles_.Size()));
+	//button metrics follow the current max state, the size comes from the grid
+	tile->maxButtonChange(!bMax, videoW, videoH, rate);
+	tile->hide();
+	connect(tile, &VideoWidget::fullScreenSignal,
+		this, &DlgVideoRoom::on_fullScreen);
+	connect(tile, &VideoWidget::muteVideoSignal,
+		this, &DlgVideoRoom::on_muteVideo);
+	connect(tile, &VideoWidget::muteAudioSignal,
+		this, &DlgVideoRoom::on_muteAudio);
+	return tile;
 }
 
-void DlgVideoRoom::setTitleLayout()
-{
-	ui.labTitle->setMaximumSize(QSize(labTitleW / rate, labTitleH / rate));
-	ui.labTitle->setMinimumSize(QSize(labTitleW / rate, labTitleH / rate));
 
-	ui.btnPrePage->setMaximumSize(QSize(pageBtnW / rate, pageBtnH / rate));
-	ui.btnPrePage->setMinimumSize(QSize(pageBtnW / rate, pageBtnH / rate));
-	ui.btnNextPage->setMaximumSize(QSize(pageBtnW / rate, pageBtnH / rate));
-	ui.btnNextPage->setMinimumSize(QSize(pageBtnW / rate, pageBtnH / rate));
+//title bar, title and bottom label shared by the video room and the extend screen,
+//metrics in base pixels of a 1920 wide screen
+template <class DlgUi>
+static void BuildRoomLayoutSpec(DlgUi& ui, LayoutSpec& spec)
+{
+	//top buttons, right aligned
+	QWidget* topButtons[] = { ui.closeButton, ui.minButton, ui.maxButton, ui.settingsButton };
+	for (QWidget* button : topButtons)
+		spec.FixedSize(button, 50, 50);
+	spec.Spacing(ui.horizontalLayout_titleButton, 25);
+	spec.Margins(ui.horizontalLayout_titleButton, [](const LayoutContext& context) {
+		int left = context.screen.width() - (int)((50 * 4 + 25 * 3) * context.scale);
+		return QMargins(left, (int)(10 * context.scale), (int)(20 * context.scale), 0);
+	});
 
 	//title
-	QString style = QString::fromUtf8("font-size: %1px;\n"
+	spec.FixedSize(ui.labTitle, 192, 67);
+	spec.FixedSize(ui.btnPrePage, 52, 52);
+	spec.FixedSize(ui.btnNextPage, 52, 52);
+	spec.Style(ui.labTitle, QString::fromUtf8("font-size: %1px;\n"
 		"border-image: url(:/AgoraCourse/Resources/dualTeacher);\n"
 		"font-weight: 500;\n"
 		"color: #000000;\n"
 		"line-height: %2px;\n"
-		"background-color:#00000000").arg(int(titleFontSize / rate)).arg(titleHeight / rate);
-	ui.labTitle->setStyleSheet(style);
-	ui.labTitle->setMaximumSize(QSize(labTitleW / rate, labTitleH / rate));
-	ui.labTitle->setMinimumSize(QSize(labTitleW / rate, labTitleH / rate));
-	ui.horizontalLayout_Title->setContentsMargins(0, 0, titleBottomMargin / rate, 0);
-	ui.horizontalLayout_Mid->setContentsMargins(midMargin / rate, 0, midMargin / rate, 0);
+		"background-color:#00000000"), 48, 67);
+	spec.Margins(ui.horizontalLayout_Title, 0, 0, 20, 0);
+	spec.Margins(ui.horizontalLayout_Mid, 98, 0, 98, 0);
+
+	//corpration label, centered
+	spec.Style(ui.label, QString::fromUtf8("font-size: %1px;\n"
+		"font-family: Helvetica;\n"
+		"color: #575757;\n"
+		"line-height: %2px;\n"
+		"background-color: rgba(0, 0, 0, 0);\n"
+		"border-image: url(:/AgoraCourse/Resources/dualTeacher);"), 24, 29);
+	spec.MaximumWidth(ui.label, 200);
+	spec.Margins(ui.horizontalLayout_2, [](const LayoutContext& context) {
+		int leftMargin = (context.screen.width() - (int)(200 * context.scale)) / 2;
+		return QMargins(leftMargin, (int)(18 * context.scale), leftMargin, (int)(35 * context.scale));
+	});
+}
+
+void DlgVideoRoom::BuildLayoutSpec()
+{
+	LayoutSpec spec;
+	BuildRoomLayoutSpec(ui, spec);
+	//grid area, VideoGrid centers and spaces the tiles inside it
+	spec.Spacing(ui.verticalLayout_Widget, 0);
+	spec.Margins(ui.verticalLayout_Widget, 73, 10, 73, 10);
+	spec.Spacing(ui.horizontalLayout_Row1, 0);
+	spec.Spacing(ui.horizontalLayoutRow2, 0);
+	layout_.SetSpec(spec);
+}
+
+void DlgVideoRoom::ApplyLayout()
+{
+	LayoutContext context;
+	context.screen = rcMainScreen;
+	context.scale = initRate / rate;
+	context.max = bMax;
+	layout_.Apply(context);
 }
 
 void DlgVideoRoom::showPage(bool bShow)
@@ -2544,38 +2591,9 @@ void DlgVideoRoom::showPage(bool bShow)
 	}
 }
 
-void DlgVideoRoom::setOptionLayout()
-{
-	//ui.verticalLayout_Widget->setMinimumSize(QSize((2 * videoH + videoSpace) / rate, (2 * videoW + videoSpace) / rate));
-	ui.verticalLayout_Widget->setSpacing(videoSpace / rate);
-	int verticalMargin = 10;
-	if (!videoWidget[3]->isVisible())
-		verticalMargin = (videoH + videoSpace) / (rate * 2.0);
-	ui.verticalLayout_Widget->setContentsMargins(videoMargin / rate, verticalMargin, videoMargin / rate, verticalMargin);
-	ui.horizontalLayout_Row1->setSpacing(videoSpace / rate);
-	ui.horizontalLayoutRow2->setSpacing(videoSpace / rate);
-}
-
-void DlgVideoRoom::setBottomLabel()
-{
-	//corpration label
-	QString style = QString::fromUtf8("font-size: %1px;\n"
-		"font-family: Helvetica;\n"
-		"color: #575757;\n"
-		"line-height: %2px;\n"
-		"background-color: rgba(0, 0, 0, 0);\n"
-		"border-image: url(:/AgoraCourse/Resources/dualTeacher);").arg((int)(bottomFontSize / rate)).arg((int)(bottomLineHeight / rate));
-	ui.label->setStyleSheet(style);
-	ui.label->setMaximumWidth(bottomLabelW / rate);
-	float leftMargin = (rcMainScreen.width() - bottomLabelW / rate) / 2;
-	ui.horizontalLayout_2->setContentsMargins(QMargins(leftMargin, bottomTopMargin / rate, leftMargin, bottomLabelBottomMargin / rate));
-}
-
 void DlgVideoRoom::UpdateLayout()
 {
-	setTopButtonLayout();
-	setTitleLayout();
-	setOptionLayout();
+	ApplyLayout();
 	ui.btnPrePage->show();
 	ui.btnNextPage->show();
 }
@@ -2596,7 +2614,6 @@ void DlgVideoRoom::ShowTopAndBottom(bool bShow)
 		ui.horizontalLayout_titleButton->setContentsMargins(0, 0, 0, 0);
 		ui.horizontalLayout_Mid->setContentsMargins(0, 0, 0, 0);
 		ui.verticalLayout_Widget->setSpacing(0);
-		int verticalMargin = (videoH + videoSpace) / 2.0f;
 		ui.verticalLayout_Widget->setContentsMargins(0, 0, 0, 0);
 		ui.horizontalLayout_Row1->setSpacing(0);
 		ui.horizontalLayoutRow2->setSpacing(0);
@@ -2609,6 +2626,7 @@ void DlgVideoRoom::ShowTopAndBottom(bool bShow)
 		ui.settingsButton->hide();
 		ui.label->hide();
 		ui.closeButton->hide();
+		layout_.Invalidate();
 	}
 }
 
@@ -2622,15 +2640,13 @@ void DlgVideoRoom::SetControlMax(bool max)
 	this->setGeometry(rcMainScreen);
 	ui.horizontalLayoutWidget->setGeometry(rcWidget);
 
-	setTopButtonLayout();
-	setTitleLayout();
-	for (int i = 0; i < 4; ++i) {
-		videoWidget[i]->maxButtonChange(max, videoW, videoH, rate);
+	for (int i = 0; i < tiles_.Size(); ++i) {
+		tiles_.At(i)->maxButtonChange(max, videoW, videoH, rate);
 	}
-	setOptionLayout();
-	setBottomLabel();
-	ui.horizontalLayoutWidget->hide();
-	ui.horizontalLayoutWidget->show();
+	ApplyLayout();
+	ui.horizontalLayoutWidget->layout()->activate();
+	//maxButtonChange gave the tiles the 1v4 size, the cells may differ
+	ShowWidgets();
 }
 
 void DlgVideoRoom::maxButtonChange(bool max)
@@ -2700,6 +2716,39 @@ void VideoWidget::InitWidget()
 		, this, &VideoWidget::renderFrame);
 }
 
+//one sheet for every tile button state, parsed once per tile; a state change
+//only flips a dynamic property and repolishes that button
+static const QString& VideoButtonStyleSheet()
+{
+	static const QString style = QString::fromUtf8(
+		"QPushButton#btnMic, QPushButton#btnCamera, QPushButton#btnFullScreen{\n"
+		"background-position:center;\n"
+		"background-repeat: none;\n"
+		"background-color: rgba(0, 0, 0, 0.55);\n"
+		"border-color: #565656;\n"
+		"border-width: 1px;\n"
+		"border-radius: 6px;\n"
+		"}\n"
+		"QPushButton#btnMic[muted=\"false\"]{border-image: url(:/AgoraCourse/Resources/dualTeacher/microphone-func.png);}\n"
+		"QPushButton#btnMic[muted=\"true\"]{border-image: url(:/AgoraCourse/Resources/dualTeacher/microphone-off-func.png);}\n"
+		"QPushButton#btnCamera[muted=\"false\"]{border-image: url(:/AgoraCourse/Resources/dualTeacher/camera-func.png);}\n"
+		"QPushButton#btnCamera[muted=\"true\"]{border-image: url(:/AgoraCourse/Resources/dualTeacher/camera-off-func.png);}\n"
+		"QPushButton#btnFullScreen[full=\"false\"]{border-image: url(:/AgoraCourse/Resources/dualTeacher/fullscreen-func.png);}\n"
+		"QPushButton#btnFullScreen[full=\"true\"]{border-image: url(:/AgoraCourse/Resources/dualTeacher/fullmin-func.png);}\n");
+	return style;
+}
+
+//repolish only when the value really changes, Reset sets the same state on every tile
+static void SetButtonState(QPushButton* button, const char* name, bool value)
+{
+	QVariant current = button->property(name);
+	if (current.isValid() && current.toBool() == value)
+		return;
+	button->setProperty(name, value);
+	button->style()->unpolish(button);
+	button->style()->polish(button);
+}
+
 void VideoWidget::InitButton()
 {
 	btnUser = new QPushButton(ui.verticalLayoutWidget);
@@ -2710,6 +2759,7 @@ void VideoWidget::InitButton()
 	btnUser->setMinimumSize(QSize(btnUserW / rate_ * 3 / 4, btnUserH / rate_ * 3 / 4));
 	btnUser->setMaximumSize(QSize(btnUserW / rate_, btnUserH / rate_));
 	int radius = btnUserH / rate_ /2;
+	userRadius_ = radius;
 	btnUser->setGeometry(userX / rate_, userX / rate_, btnUserW / rate_, btnUserH / rate_);
 	btnUser->setStyleSheet(QString::fromUtf8("QPushButton#btnUser{\n"
 		"border-width: 1px;\n"
@@ -2753,37 +2803,11 @@ void VideoWidget::InitButton()
 	x = x - (btnW + btnSpacing) / rate_;
 	btnCamera->setGeometry(x, y, btnW / rate_, btnW / rate_);
 
-
-	btnFullScreen->setStyleSheet(QString::fromUtf8("QPushButton#btnFullScreen{\n"
-		"border-image: url(:/AgoraCourse/Resources/dualTeacher/fullscreen-func.png);\n"
-		"background-position:center;\n"
-		"background-repeat: none;\n"
-		"background-color: rgba(0, 0, 0, 0.55);\n"
-		"border-color: #565656;\n"
-		"border-width: 1px;\n"
-		"border-radius: 6px;\n"
-		"};"));
-	QString img = QString("microphone-func.png");//microphone-func.png
-
-	QString style = QString::fromUtf8("QPushButton#btnMic{\n"
-		"border-image: url(:/AgoraCourse/Resources/dualTeacher/%1);\n"
-		"background-position:center;\n"
-		"background-repeat: none;\n"
-		"background-color: rgba(0, 0, 0, 0.55);\n"
-		"border-color: #565656;\n"
-		"border-width: 1px;\n"
-		"border-radius: 6px;\n"
-		"};").arg(img);
-	btnMic->setStyleSheet(style);
-	btnCamera->setStyleSheet(QString::fromUtf8("QPushButton#btnCamera{\n"
-		"border-image: url(:/AgoraCourse/Resources/dualTeacher/%1);\n"
-		"background-position:center;\n"
-		"background-repeat: none;\n"
-		"background-color: rgba(0, 0, 0, 0.55);\n"
-		"border-color: #565656;\n"
-		"border-width: 1px;\n"
-		"border-radius: 6px;\n"
-		"};").arg("camera-func.png"));
+	//states before the sheet, so the first polish already matches
+	btnFullScreen->setProperty("full", false);
+	btnMic->setProperty("muted", false);
+	btnCamera->setProperty("muted", false);
+	ui.verticalLayoutWidget->setStyleSheet(VideoButtonStyleSheet());
 	btnCamera->setFlat(true);
 
 	connect(btnCamera, &QPushButton::clicked, this, &VideoWidget::on_btnCamera_clicked);
@@ -2811,18 +2835,35 @@ void VideoWidget::MaximizeWidget(int width, int height)
 	ui.widgetFrame->setMinimumSize(QSize(w, h));
 }
 
+//cell of the video room grid, the buttons keep their size and follow the corner
+void VideoWidget::SetTileGeometry(const QRect& rc)
+{
+	if (geometry() == rc && minimumSize() == rc.size() && maximumSize() == rc.size())
+		return;
+	setFixedSize(rc.size());
+	setGeometry(rc);
+	ui.widgetFrame->setFixedSize(rc.size());
+	ui.widgetFrame->setGeometry(0, 0, rc.width(), rc.height());
+	ui.verticalLayoutWidget->setGeometry(0, 0, rc.width(), rc.height());
+	UpdateButtonPos();
+}
+
 void VideoWidget::UpdateButtonPos()
 {
 	btnUser->setMinimumSize(QSize(btnUserW / rate_ * 3 / 4, btnUserH / rate_ * 3 / 4));
 	btnUser->setMaximumSize(QSize(btnUserW / rate_, btnUserH / rate_));
 	int radius = btnUserH / rate_ / 2;
 	btnUser->setGeometry(userX / rate_, userX / rate_, btnUserW / rate_, btnUserH / rate_);
-	btnUser->setStyleSheet(QString::fromUtf8("QPushButton#btnUser{\n"
-		"border-width: 1px;\n"
-		"background-color: rgba(255,255,255,0.6);\n"
-		"border-color:rgba(255,255,255,0.6);\n"
-		"border-radius: %1px;\n"
-		"}").arg(radius));
+	//the radius only changes with rate_, skip the reparse on plain moves
+	if (radius != userRadius_) {
+		userRadius_ = radius;
+		btnUser->setStyleSheet(QString::fromUtf8("QPushButton#btnUser{\n"
+			"border-width: 1px;\n"
+			"background-color: rgba(255,255,255,0.6);\n"
+			"border-color:rgba(255,255,255,0.6);\n"
+			"border-radius: %1px;\n"
+			"}").arg(radius));
+	}
 
 	int y = this->height() - (btnPadding + btnW) / rate_;
 	int x = this->width() - (btnPadding + btnW) / rate_;
@@ -2836,52 +2877,18 @@ void VideoWidget::UpdateButtonPos()
 
 void VideoWidget::SetMicButtonStats(bool mute)
 {
-	//mic
-	QString style = QString::fromUtf8("QPushButton#btnMic{\n"
-		"border-image: url(:/AgoraCourse/Resources/dualTeacher/%1);\n"
-		"background-position:center;\n"
-		"background-repeat: none;\n"
-		"background-color: rgba(0, 0, 0, 0.55);\n"
-		"border-color: #565656;\n"
-		"border-width:  1px;\n"
-		"border-radius: 6px;\n"
-		"};").arg(mute ? "microphone-off-func.png" : "microphone-func.png");
-	
-	btnMic->setStyleSheet(style);
+	SetButtonState(btnMic, "muted", mute);
 }
 
 
 void VideoWidget::SetCameraButtonStats(bool mute)
 {
-	//mic
-	QString style = QString::fromUtf8("QPushButton#btnCamera{\n"
-		"border-image: url(:/AgoraCourse/Resources/dualTeacher/%1);\n"
-		"background-position:center;\n"
-		"background-repeat: none;\n"
-		"background-color: rgba(0, 0, 0, 0.55);\n"
-		"border-color: #565656;\n"
-		"border-width: 1px;\n"
-		"border-radius: 6px;\n"
-		"};").arg(mute ? "camera-off-func.png" : "camera-func.png");
-
-	btnCamera->setStyleSheet(style);
-	btnCamera->setFlat(true);
+	SetButtonState(btnCamera, "muted", mute);
 }
 
 void VideoWidget::SetFullScreenButtonStats(bool full)
 {
-	//mic
-	QString style = QString::fromUtf8("QPushButton#btnFullScreen{\n"
-		"border-image: url(:/AgoraCourse/Resources/dualTeacher/%1);\n"
-		"background-position:center;\n"
-		"background-repeat: none;\n"
-		"background-color: rgba(0, 0, 0, 0.55);\n"
-		"border-color: #565656;\n"
-		"border-width: 1px;\n"
-		"border-radius: 6px;\n"
-		"};").arg(full ? "fullmin-func.png" : "fullscreen-func.png");
-
-	btnFullScreen->setStyleSheet(style);
+	SetButtonState(btnFullScreen, "full", full);
 }
 
 void VideoWidget::maxButtonChange(bool max, int w, int h, float rate)
@@ -2914,32 +2921,9 @@ void DlgExtend::InitDlg()
 	rate = rate2;
 	int w = rcSecondScreen.width() * rate;
 	initRate = w / 1920.0f;
-	//top button
-	topButtonSpace = 25* initRate;
-	topButtonWidth = 50* initRate;
-	topButtonTopMargin = 10* initRate;
-	topButtonRightMargin = 20* initRate;
-	bottomFontSize = 24* initRate;
-	bottomLineHeight = 29* initRate;
-
-	bottomLabelW = 200* initRate;
-	bottomLabelBottomMargin = 35* initRate;
-	//title
-	titleHeight = 67* initRate;
-	titleFontSize = 48* initRate;
-	titleTopMargin = 48* initRate;
-	titleBottomMargin = 20* initRate;
-	labTitleW = 192* initRate;
-	labTitleH = 67* initRate;
-	//video widget
+	//video widget, the rest of the geometry is in BuildLayoutSpec
 	videoW = 710* initRate;
 	videoH = 400* initRate;
-	videoSpace = 36* initRate;
-	videoMargin = 73* initRate;
-	pageBtnW = 52* initRate;
-	pageBtnH = 52* initRate;
-	midMargin = 98* initRate;
-	bottomTopMargin = 18* initRate;
 
 	this->setGeometry(rcSecondScreen);
 	QString style = QString::fromUtf8("QWidget#horizontalLayoutWidget{"
@@ -2949,8 +2933,6 @@ void DlgExtend::InitDlg()
 	QRect rc = { 0, 0, rcSecondScreen.width(), rcSecondScreen.height() };
 	ui.horizontalLayoutWidget->setGeometry(rc);
 	ui.horizontalLayoutWidget->setStyleSheet(style);
-	setTopButtonLayout();
-	setTitleLayout();
 	for (int i = 0; i < 2; ++i) {
 		videoWidget[i] = new VideoWidget(initRate, rate, ui.horizontalLayoutWidget);
 		videoWidget[i]->setObjectName(QString::fromUtf8("widget_%1").arg(i));
@@ -2963,8 +2945,8 @@ void DlgExtend::InitDlg()
 			ui.horizontalLayoutRow2->addWidget(videoWidget[i]);
 	}
 	
-	setOptionLayout();
-	setBottomLabel();
+	BuildLayoutSpec();
+	ApplyLayout();
 	
 	for (int i = 0; i < 2; ++i) {
 		connect(videoWidget[i], &VideoWidget::fullScreenSignal,
@@ -2977,80 +2959,33 @@ void DlgExtend::InitDlg()
 }
 
 
-void DlgExtend::setTopButtonLayout()
-{
-	float w = topButtonWidth / rate;
-	float buttonLeftMargin = rcMainScreen.width() - (w * 4 + 3 * topButtonSpace / rate);
-	ui.closeButton->setMaximumSize(w, w);
-	ui.closeButton->setMinimumSize(w, w);
-
-	ui.minButton->setMaximumSize(w, w);
-	ui.minButton->setMinimumSize(w, w);
-
-	ui.maxButton->setMaximumSize(w, w);
-	ui.maxButton->setMinimumSize(w, w);
-
-	ui.settingsButton->setMaximumSize(w, w);
-	ui.settingsButton->setMinimumSize(w, w);
-	//layout
-	ui.horizontalLayout_titleButton->setSpacing(topButtonSpace / rate);
-	ui.horizontalLayout_titleButton->setContentsMargins(buttonLeftMargin, topButtonTopMargin / rate, topButtonRightMargin / rate, 0);
-}
-
-
-void DlgExtend::setTitleLayout()
-{
-	ui.labTitle->setMaximumSize(QSize(labTitleW / rate, labTitleH / rate));
-	ui.labTitle->setMinimumSize(QSize(labTitleW / rate, labTitleH / rate));
-
-	ui.btnPrePage->setMaximumSize(QSize(pageBtnW / rate, pageBtnH / rate));
-	ui.btnPrePage->setMinimumSize(QSize(pageBtnW / rate, pageBtnH / rate));
-	ui.btnNextPage->setMaximumSize(QSize(pageBtnW / rate, pageBtnH / rate));
-	ui.btnNextPage->setMinimumSize(QSize(pageBtnW / rate, pageBtnH / rate));
-
-	//title
-	QString style = QString::fromUtf8("font-size: %1px;\n"
-		"border-image: url(:/AgoraCourse/Resources/dualTeacher);\n"
-		"font-weight: 500;\n"
-		"color: #000000;\n"
-		"line-height: %2px;\n"
-		"background-color:#00000000").arg(int(titleFontSize / rate)).arg(titleHeight / rate);
-	ui.labTitle->setStyleSheet(style);
-	ui.labTitle->setMaximumSize(QSize(labTitleW / rate, labTitleH / rate));
-	ui.labTitle->setMinimumSize(QSize(labTitleW / rate, labTitleH / rate));
-	ui.horizontalLayout_Title->setContentsMargins(0, 0, titleBottomMargin / rate, 0);
-	ui.horizontalLayout_Mid->setContentsMargins(midMargin / rate, 0, midMargin / rate, 0);
-}
-void DlgExtend::setOptionLayout()
+void DlgExtend::BuildLayoutSpec()
 {
-	//ui.verticalLayout_Widget->setMinimumSize(QSize((2 * videoH + videoSpace) / rate, (2 * videoW + videoSpace) / rate));
-	ui.verticalLayout_Widget->setSpacing(videoSpace / rate);
-	int verticalMargin = videoH / (rate * 2.0);
-	ui.verticalLayout_Widget->setContentsMargins(videoMargin / rate, verticalMargin, videoMargin / rate, verticalMargin);
-	ui.horizontalLayout_Row1->setSpacing(videoSpace / rate);
-	ui.horizontalLayoutRow2->setSpacing(0);
+	LayoutSpec spec;
+	BuildRoomLayoutSpec(ui, spec);
+	//one row of two videos, centered vertically
+	spec.Spacing(ui.verticalLayout_Widget, 36);
+	spec.Margins(ui.verticalLayout_Widget, [](const LayoutContext& context) {
+		int verticalMargin = (int)(400 * context.scale / 2);
+		return QMargins((int)(73 * context.scale), verticalMargin, (int)(73 * context.scale), verticalMargin);
+	});
+	spec.Spacing(ui.horizontalLayout_Row1, 36);
+	spec.Spacing(ui.horizontalLayoutRow2, 0);
+	layout_.SetSpec(spec);
 }
 
-void DlgExtend::setBottomLabel()
+void DlgExtend::ApplyLayout()
 {
-	//corpration label
-	QString style = QString::fromUtf8("font-size: %1px;\n"
-		"font-family: Helvetica;\n"
-		"color: #575757;\n"
-		"line-height: %2px;\n"
-		"background-color: rgba(0, 0, 0, 0);\n"
-		"border-image: url(:/AgoraCourse/Resources/dualTeacher);").arg((int)(bottomFontSize / rate)).arg((int)(bottomLineHeight / rate));
-	ui.label->setStyleSheet(style);
-	ui.label->setMaximumWidth(bottomLabelW / rate);
-	float leftMargin = (rcSecondScreen.width() - bottomLabelW / rate) / 2;
-	ui.horizontalLayout_2->setContentsMargins(QMargins(leftMargin, (float)bottomTopMargin / rate, leftMargin, bottomLabelBottomMargin / rate));
+	LayoutContext context;
+	context.screen = rcMainScreen;
+	context.scale = initRate / rate;
+	context.max = bMax;
+	layout_.Apply(context);
 }
 
 void DlgExtend::UpdateLayout()
 {
-	setTopButtonLayout();
-	setTitleLayout();
-	setOptionLayout();
+	ApplyLayout();
 	ui.btnPrePage->show();
 	ui.btnNextPage->show();
 }
@@ -3072,7 +3007,6 @@ void DlgExtend::ShowTopAndBottom(bool bShow)
 		ui.horizontalLayout_titleButton->setContentsMargins(0, 0, 0, 0);
 		ui.horizontalLayout_Mid->setContentsMargins(0, 0, 0, 0);
 		ui.verticalLayout_Widget->setSpacing(0);
-		int verticalMargin = (videoH + videoSpace) / 2.0f;
 		ui.verticalLayout_Widget->setContentsMargins(0, 0, 0, 0);
 		ui.horizontalLayout_Row1->setSpacing(0);
 		ui.horizontalLayoutRow2->setSpacing(0);
@@ -3085,6 +3019,7 @@ void DlgExtend::ShowTopAndBottom(bool bShow)
 		ui.settingsButton->hide();
 		ui.label->hide();
 		ui.closeButton->hide();
+		layout_.Invalidate();
 	}
 }
 
@@ -3129,15 +3064,11 @@ void DlgExtend::SetControlMax(bool max)
 	this->setGeometry(rcMainScreen);
 	ui.horizontalLayoutWidget->setGeometry(rcWidget);
 
-	setTopButtonLayout();
-	setTitleLayout();
 	for (int i = 0; i < 2; ++i) {
 		videoWidget[i]->maxButtonChange(max, videoW, videoH, rate);
 	}
-	setOptionLayout();
-	setBottomLabel();
-	ui.horizontalLayoutWidget->hide();
-	ui.horizontalLayoutWidget->show();
+	ApplyLayout();
+	ui.horizontalLayoutWidget->layout()->activate();
 }
 void DlgExtend::on_fullMaxButton_clicked(bool bMax)
 {
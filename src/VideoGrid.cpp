@@ -0,0 +1,104 @@
+#include "VideoGrid.h"
+
+#include <algorithm>
+
+int videoGridCapacity(STUDENT_1VN_TYPE type)
+{
+	switch (type) {
+	case STUDENT_1V1:
+		return 2;
+	case STUDENT_1V9:
+		return 9;
+	case STUDENT_1V12:
+		return 12;
+	case STUDENT_1V16:
+		return 16;
+	case STUDENT_1V4:
+	default:
+		return 4;
+	}
+}
+
+const char* videoGridName(STUDENT_1VN_TYPE type)
+{
+	switch (type) {
+	case STUDENT_1V1:
+		return "1v1";
+	case STUDENT_1V9:
+		return "1v9";
+	case STUDENT_1V12:
+		return "1v12";
+	case STUDENT_1V16:
+		return "1v16";
+	case STUDENT_1V4:
+	default:
+		return "1v4";
+	}
+}
+
+void VideoGrid::SetMode(STUDENT_1VN_TYPE type)
+{
+	if (type == mode_)
+		return;
+	mode_ = type;
+	count_ = -1;
+}
+
+void VideoGrid::SetLocalTiles(int count)
+{
+	if (count == localTiles_)
+		return;
+	localTiles_ = count;
+	count_ = -1;
+}
+
+const QVector<QRect>& VideoGrid::Cells(int count, const QRect& area, int spacing, const QSize& maxCell)
+{
+	count = (std::min)(count, Capacity());
+	if (count == count_ && area == area_ && spacing == spacing_ && maxCell == maxCell_)
+		return cells_;
+	count_ = count;
+	area_ = area;
+	spacing_ = spacing;
+	maxCell_ = maxCell;
+	cells_.clear();
+	columns_ = 0;
+	rows_ = 0;
+	if (count <= 0 || area.isEmpty())
+		return cells_;
+
+	//widest 16:9 cell; on a tie (capped cells) fewer rows, then fewer columns
+	int cellWidth = 0;
+	for (int columns = 1; columns <= count; ++columns) {
+		int rows = (count + columns - 1) / columns;
+		int width = (area.width() - (columns - 1) * spacing) / columns;
+		int height = (area.height() - (rows - 1) * spacing) / rows;
+		width = (std::min)(width, height * 16 / 9);
+		if (maxCell.isValid())
+			width = (std::min)(width, (std::min)(maxCell.width(), maxCell.height() * 16 / 9));
+		if (width > cellWidth || (width == cellWidth && rows < rows_)) {
+			cellWidth = width;
+			columns_ = columns;
+			rows_ = rows;
+		}
+	}
+	int cellHeight = cellWidth * 9 / 16;
+	if (cellWidth <= 0 || cellHeight <= 0) {
+		columns_ = 0;
+		rows_ = 0;
+		return cells_;
+	}
+
+	int gridHeight = rows_ * cellHeight + (rows_ - 1) * spacing;
+	int top = area.top() + (area.height() - gridHeight) / 2;
+	for (int i = 0; i < count; ++i) {
+		int row = i / columns_;
+		int column = i % columns_;
+		int rowCount = (std::min)(columns_, count - row * columns_);
+		int rowWidth = rowCount * cellWidth + (rowCount - 1) * spacing;
+		int left = area.left() + (area.width() - rowWidth) / 2;
+		cells_.push_back(QRect(left + column * (cellWidth + spacing),
+			top + row * (cellHeight + spacing), cellWidth, cellHeight));
+	}
+	return cells_;
+}
@@ -0,0 +1,44 @@
+#ifndef VIDEOGRID_H
+#define VIDEOGRID_H
+
+#include <QRect>
+#include <QSize>
+#include <QVector>
+
+#include "SettingsData.h"
+
+//students per page of a 1vN class: N, the four of the original room for 1v4;
+//1v1 shows both the teacher and the student
+int videoGridCapacity(STUDENT_1VN_TYPE type);
+const char* videoGridName(STUDENT_1VN_TYPE type);
+
+// Cell geometry of the video room tile grid.
+// The occupied tiles of a page get the column count that gives them the
+// largest 16:9 cells in the area, never larger than maxCell; the last row
+// is centered. The result is kept until one of the inputs changes.
+class VideoGrid
+{
+public:
+	void SetMode(STUDENT_1VN_TYPE type);
+	STUDENT_1VN_TYPE Mode() const { return mode_; }
+	//local tiles (cameras, player, screen share) shown in the room, they do not take a student's place
+	void SetLocalTiles(int count);
+	int Capacity() const { return videoGridCapacity(mode_) + localTiles_; }
+
+	//cells in reading order for min(count, Capacity()) tiles, none when the area cannot hold a cell
+	const QVector<QRect>& Cells(int count, const QRect& area, int spacing, const QSize& maxCell);
+	int Columns() const { return columns_; }
+	int Rows() const { return rows_; }
+private:
+	STUDENT_1VN_TYPE mode_ = STUDENT_1V4;
+	int localTiles_ = 0;
+	int count_ = -1;
+	QRect area_;
+	int spacing_ = 0;
+	QSize maxCell_;
+	int columns_ = 0;
+	int rows_ = 0;
+	QVector<QRect> cells_;
+};
+
+#endif // VIDEOGRID_H
@@ -0,0 +1,111 @@
+#include "VideoSource.h"
+
+VideoSource::VideoSource(VIDEO_SOURCE_KIND kind)
+	: kind_(kind)
+{
+	connection_.channelId = channelId_.c_str();
+	connection_.localUid = 0;
+	publishAudio = (kind == VIDEO_SOURCE_CAMERA_PRIMARY || kind == VIDEO_SOURCE_MEDIA_PLAYER);
+}
+
+VideoSource::~VideoSource()
+{
+}
+
+void VideoSource::SetConnection(const char* channel, agora::rtc::uid_t uid)
+{
+	channelId_ = channel ? channel : "";
+	connection_.channelId = channelId_.c_str();
+	connection_.localUid = uid;
+}
+
+void VideoSource::SetColorInfo(const VideoColorInfo& color)
+{
+	color_ = color.matrix | (color.fullRange ? 1 << 8 : 0);
+}
+
+VideoColorInfo VideoSource::ColorInfo() const
+{
+	int value = color_;
+	VideoColorInfo color;
+	color.matrix = value & 0xff;
+	color.fullRange = (value >> 8) != 0;
+	return color;
+}
+
+agora::rtc::ChannelMediaOptions VideoSource::BuildMediaOptions() const
+{
+	agora::rtc::ChannelMediaOptions option;
+	option.publishAudioTrack = false;
+	option.publishCameraTrack = false;
+	switch (kind_) {
+	case VIDEO_SOURCE_CAMERA_PRIMARY:
+		option.publishAudioTrack = publishAudio;
+		option.publishCameraTrack = publishVideo;
+		break;
+	case VIDEO_SOURCE_MEDIA_PLAYER:
+		option.publishMediaPlayerAudioTrack = publishAudio;
+		option.publishMediaPlayerVideoTrack = publishVideo;
+		option.publishMediaPlayerId = mediaPlayerId;
+		break;
+	case VIDEO_SOURCE_CAMERA_SECONDARY:
+		option.publishSecondaryCameraTrack = publishVideo;
+		break;
+	case VIDEO_SOURCE_SCREEN:
+		option.publishScreenTrack = publishVideo;
+		break;
+	default:
+		break;
+	}
+	option.clientRoleType = agora::rtc::CLIENT_ROLE_BROADCASTER;
+	option.channelProfile = agora::CHANNEL_PROFILE_LIVE_BROADCASTING;
+	return option;
+}
+
+VideoSource* VideoSourceRegistry::Add(VIDEO_SOURCE_KIND kind)
+{
+	std::unique_ptr<VideoSource>& source = sources_[kind];
+	if (!source)
+		source.reset(new VideoSource(kind));
+	return source.get();
+}
+
+VideoSource* VideoSourceRegistry::Get(VIDEO_SOURCE_KIND kind) const
+{
+	auto iter = sources_.find(kind);
+	return iter == sources_.end() ? nullptr : iter->second.get();
+}
+
+VideoSource* VideoSourceRegistry::FindByUid(agora::rtc::uid_t uid) const
+{
+	if (uid == 0)
+		return nullptr;
+	for (auto iter = sources_.begin(); iter != sources_.end(); ++iter) {
+		if (iter->second->Uid() == uid)
+			return iter->second.get();
+	}
+	return nullptr;
+}
+
+bool VideoSourceRegistry::IsLocalUid(agora::rtc::uid_t uid) const
+{
+	return FindByUid(uid) != nullptr;
+}
+
+std::vector<VideoSource*> VideoSourceRegistry::Sources() const
+{
+	std::vector<VideoSource*> sources;
+	for (auto iter = sources_.begin(); iter != sources_.end(); ++iter)
+		sources.push_back(iter->second.get());
+	return sources;
+}
+
+std::vector<VideoSource*> VideoSourceRegistry::JoinedSources() const
+{
+	std::vector<VideoSource*> sources;
+	for (auto iter = sources_.begin(); iter != sources_.end(); ++iter) {
+		if (iter->second->IsJoined())
+			sources.push_back(iter->second.get());
+	}
+	return sources;
+}
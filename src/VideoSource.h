@@ -0,0 +1,83 @@
+#ifndef VIDEOSOURCE_H
+#define VIDEOSOURCE_H
+
+#include <IAgoraRtcEngine.h>
+#include <IAgoraRtcEngineEx.h>
+
+#include "video_frame_copy.h"
+
+#include <QString>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Local publishers of the dual teacher client. Every kind joins the
+// channel on its own RtcConnection with its own uid.
+enum VIDEO_SOURCE_KIND
+{
+	VIDEO_SOURCE_CAMERA_PRIMARY = 0, //teacher camera, also publishes the microphone
+	VIDEO_SOURCE_MEDIA_PLAYER,       //url opened by the media player
+	VIDEO_SOURCE_CAMERA_SECONDARY,   //document camera
+	VIDEO_SOURCE_SCREEN,             //screen share
+	VIDEO_SOURCE_COUNT
+};
+
+class VideoSource
+{
+public:
+	VideoSource(VIDEO_SOURCE_KIND kind);
+	~VideoSource();
+
+	VIDEO_SOURCE_KIND Kind() const { return kind_; }
+	agora::rtc::uid_t Uid() const { return connection_.localUid; }
+	const agora::rtc::RtcConnection& Connection() const { return connection_; }
+	void SetConnection(const char* channel, agora::rtc::uid_t uid);
+
+	bool IsJoined() const { return joined_; }
+	void SetJoined(bool joined) { joined_ = joined; }
+
+	//publish
+	bool publishAudio = false;
+	bool publishVideo = true;
+	int mediaPlayerId = -1;
+	//encoder, applied after join when hasEncoderConfig is set
+	bool hasEncoderConfig = false;
+	agora::rtc::VideoEncoderConfiguration encoderConfig;
+	//data stream created on first use, reset on leave
+	int dataStreamId = -1;
+	//YUV interpretation of the capture frames, which carry none; read on the capture thread
+	void SetColorInfo(const VideoColorInfo& color);
+	VideoColorInfo ColorInfo() const;
+
+	//publish options only, subscription is left to SubscriptionCoordinator
+	agora::rtc::ChannelMediaOptions BuildMediaOptions() const;
+	agora::rtc::IRtcEngineEventHandlerEx* EventHandler() const { return eventHandler_.get(); }
+	void SetEventHandler(agora::rtc::IRtcEngineEventHandlerEx* handler) { eventHandler_.reset(handler); }
+private:
+	VIDEO_SOURCE_KIND kind_;
+	std::string channelId_;
+	agora::rtc::RtcConnection connection_;
+	bool joined_ = false;
+	//matrix | fullRange << 8, one atomic so a frame never sees half a change
+	std::atomic<int> color_{ VIDEO_COLOR_BT601 };
+	std::unique_ptr<agora::rtc::IRtcEngineEventHandlerEx> eventHandler_;
+};
+
+// Owns one VideoSource per kind. The AgoraRtcEngine constructor creates
+// every source once, afterwards only their fields change.
+class VideoSourceRegistry
+{
+public:
+	VideoSource* Add(VIDEO_SOURCE_KIND kind);
+	VideoSource* Get(VIDEO_SOURCE_KIND kind) const;
+	VideoSource* FindByUid(agora::rtc::uid_t uid) const;
+	bool IsLocalUid(agora::rtc::uid_t uid) const;
+	std::vector<VideoSource*> Sources() const;
+	std::vector<VideoSource*> JoinedSources() const;
+private:
+	std::map<VIDEO_SOURCE_KIND, std::unique_ptr<VideoSource> > sources_;
+};
+
+#endif // VIDEOSOURCE_H
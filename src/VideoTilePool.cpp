@@ -0,0 +1,62 @@
+#include "VideoTilePool.h"
+#include "VideoWidget.h"
+
+#include <QDateTime>
+#include <QDebug>
+
+VideoTilePool::VideoTilePool(QObject* parent)
+	: QObject(parent)
+{
+	connect(&trimTimer_, &QTimer::timeout, this, &VideoTilePool::onTrimTimer);
+}
+
+VideoWidget* VideoTilePool::Tile(int index)
+{
+	while (tiles_.size() <= index) {
+		Entry entry;
+		entry.widget = create_();
+		tiles_.push_back(entry);
+	}
+	for (int i = used_; i <= index; ++i)
+		tiles_[i].idleSince = 0;
+	if (index >= used_)
+		used_ = index + 1;
+	return tiles_[index].widget;
+}
+
+void VideoTilePool::SetUsed(int count)
+{
+	qint64 now = QDateTime::currentMSecsSinceEpoch();
+	for (int i = count; i < tiles_.size(); ++i) {
+		Entry& entry = tiles_[i];
+		if (entry.idleSince != 0)
+			continue;
+		entry.idleSince = now;
+		entry.widget->hide();
+		entry.widget->ReleaseFrameBuffers();
+	}
+	for (int i = 0; i < count && i < tiles_.size(); ++i)
+		tiles_[i].idleSince = 0;
+	used_ = count < tiles_.size() ? count : tiles_.size();
+	if (used_ < tiles_.size() && !trimTimer_.isActive())
+		trimTimer_.start(idleTimeout_ / 2);
+}
+
+//only trailing tiles are deleted, so cell indexes stay contiguous
+void VideoTilePool::onTrimTimer()
+{
+	qint64 now = QDateTime::currentMSecsSinceEpoch();
+	int trimmed = 0;
+	while (tiles_.size() > used_) {
+		Entry& entry = tiles_.last();
+		if (now - entry.idleSince < idleTimeout_)
+			break;
+		delete entry.widget;
+		tiles_.removeLast();
+		++trimmed;
+	}
+	if (trimmed > 0)
+		qDebug() << "tile pool trimmed" << trimmed << "tiles, kept" << tiles_.size();
+	if (tiles_.size() == used_)
+		trimTimer_.stop();
+}
@@ -0,0 +1,53 @@
+#ifndef VIDEOTILEPOOL_H
+#define VIDEOTILEPOOL_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <functional>
+
+class VideoWidget;
+
+//idle tiles are deleted after this long without a cell
+#define TILE_POOL_IDLE_TIMEOUT_MS 30000
+
+// Video tiles of a dialog, created on demand and reused.
+// Tiles [0, used) hold grid cells. The rest are idle: hidden, without
+// frame planes, and deleted from the end after TILE_POOL_IDLE_TIMEOUT_MS,
+// which also frees their GL context. An idle tile must not be in the
+// engine widget maps. GUI thread only.
+class VideoTilePool : public QObject
+{
+	Q_OBJECT
+
+public:
+	typedef std::function<VideoWidget*()> CreateFunc;
+	VideoTilePool(QObject* parent = nullptr);
+	void SetCreateFunc(CreateFunc create) { create_ = create; }
+	void SetIdleTimeout(int ms) { idleTimeout_ = ms; }
+
+	//tile of cell index, created or taken from the idle tiles
+	VideoWidget* Tile(int index);
+	//tiles from count on become idle
+	void SetUsed(int count);
+	int Used() const { return used_; }
+	//every tile, used or idle
+	int Size() const { return tiles_.size(); }
+	VideoWidget* At(int index) const { return tiles_[index].widget; }
+private slots:
+	void onTrimTimer();
+private:
+	struct Entry
+	{
+		VideoWidget* widget = nullptr;
+		//ms of the idle start, 0 while used
+		qint64 idleSince = 0;
+	};
+	CreateFunc create_;
+	QVector<Entry> tiles_;
+	int used_ = 0;
+	int idleTimeout_ = TILE_POOL_IDLE_TIMEOUT_MS;
+	QTimer trimTimer_;
+};
+
+#endif // VIDEOTILEPOOL_H
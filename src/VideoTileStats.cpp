@@ -0,0 +1,133 @@
+#include "VideoTileStats.h"
+
+static void AddToBucket(std::atomic<unsigned int>* buckets, int64_t us)
+{
+	int64_t bucket = us / TILE_STATS_BUCKET_US;
+	if (bucket >= TILE_STATS_BUCKETS)
+		bucket = TILE_STATS_BUCKETS - 1;
+	buckets[bucket < 0 ? 0 : bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+//upper edge of the bucket holding the given share of the samples
+static float Percentile(const std::atomic<unsigned int>* buckets, unsigned int count, float share)
+{
+	if (count == 0)
+		return 0.0f;
+	unsigned int rank = (unsigned int)(count * share + 0.5f);
+	if (rank == 0)
+		rank = 1;
+	unsigned int seen = 0;
+	for (int i = 0; i < TILE_STATS_BUCKETS; ++i) {
+		seen += buckets[i].load(std::memory_order_relaxed);
+		if (seen >= rank)
+			return (i + 1) * TILE_STATS_BUCKET_US / 1000.0f;
+	}
+	return TILE_STATS_BUCKETS * TILE_STATS_BUCKET_US / 1000.0f;
+}
+
+VideoTileStats::VideoTileStats()
+	: received_(0)
+	, rendered_(0)
+	, dropped_(0)
+	, copyUs_(0)
+	, uploadUs_(0)
+	, frameWidth_(0)
+	, frameHeight_(0)
+{
+	for (int i = 0; i < TILE_STATS_BUCKETS; ++i) {
+		copyBuckets_[i] = 0;
+		uploadBuckets_[i] = 0;
+	}
+}
+
+void VideoTileStats::OnFrameCopied(int width, int height, int64_t copyUs, bool overwritten)
+{
+	received_.fetch_add(1, std::memory_order_relaxed);
+	copyUs_.fetch_add(copyUs, std::memory_order_relaxed);
+	AddToBucket(copyBuckets_, copyUs);
+	frameWidth_.store(width, std::memory_order_relaxed);
+	frameHeight_.store(height, std::memory_order_relaxed);
+	//previous frame was never painted
+	if (overwritten)
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void VideoTileStats::OnFrameRendered(int64_t uploadUs)
+{
+	rendered_.fetch_add(1, std::memory_order_relaxed);
+	uploadUs_.fetch_add(uploadUs, std::memory_order_relaxed);
+	AddToBucket(uploadBuckets_, uploadUs);
+}
+
+bool VideoTileStats::Sample(int64_t nowMs, VideoTileSnapshot& snapshot)
+{
+	if (lastSampleMs_ == 0) {
+		lastSampleMs_ = nowMs;
+		return false;
+	}
+	int64_t elapsed = nowMs - lastSampleMs_;
+	if (elapsed < 1000)
+		return false;
+
+	unsigned int received = received_.load(std::memory_order_relaxed);
+	unsigned int rendered = rendered_.load(std::memory_order_relaxed);
+	unsigned int dropped = dropped_.load(std::memory_order_relaxed);
+	int64_t copyUs = copyUs_.load(std::memory_order_relaxed);
+	int64_t uploadUs = uploadUs_.load(std::memory_order_relaxed);
+
+	unsigned int receivedDelta = received - lastReceived_;
+	unsigned int renderedDelta = rendered - lastRendered_;
+	snapshot.receivedFps = receivedDelta * 1000.0f / elapsed;
+	snapshot.renderedFps = renderedDelta * 1000.0f / elapsed;
+	snapshot.copyMs = receivedDelta ? (copyUs - lastCopyUs_) / 1000.0f / receivedDelta : 0.0f;
+	snapshot.uploadMs = renderedDelta ? (uploadUs - lastUploadUs_) / 1000.0f / renderedDelta : 0.0f;
+	snapshot.droppedFps = (dropped - lastDropped_) * 1000.0f / elapsed;
+	snapshot.frameWidth = frameWidth_.load(std::memory_order_relaxed);
+	snapshot.frameHeight = frameHeight_.load(std::memory_order_relaxed);
+
+	lastSampleMs_ = nowMs;
+	lastReceived_ = received;
+	lastRendered_ = rendered;
+	lastDropped_ = dropped;
+	lastCopyUs_ = copyUs;
+	lastUploadUs_ = uploadUs;
+	return true;
+}
+
+VideoTileTotals VideoTileStats::Totals() const
+{
+	VideoTileTotals totals;
+	totals.received = received_.load(std::memory_order_relaxed);
+	totals.rendered = rendered_.load(std::memory_order_relaxed);
+	totals.dropped = dropped_.load(std::memory_order_relaxed);
+	totals.copyUs = copyUs_.load(std::memory_order_relaxed);
+	totals.uploadUs = uploadUs_.load(std::memory_order_relaxed);
+	totals.copyP50Ms = Percentile(copyBuckets_, totals.received, 0.50f);
+	totals.copyP95Ms = Percentile(copyBuckets_, totals.received, 0.95f);
+	totals.copyP99Ms = Percentile(copyBuckets_, totals.received, 0.99f);
+	totals.uploadP50Ms = Percentile(uploadBuckets_, totals.rendered, 0.50f);
+	totals.uploadP95Ms = Percentile(uploadBuckets_, totals.rendered, 0.95f);
+	totals.uploadP99Ms = Percentile(uploadBuckets_, totals.rendered, 0.99f);
+	return totals;
+}
+
+void VideoTileStats::Reset()
+{
+	received_ = 0;
+	rendered_ = 0;
+	dropped_ = 0;
+	copyUs_ = 0;
+	uploadUs_ = 0;
+	frameWidth_ = 0;
+	frameHeight_ = 0;
+	for (int i = 0; i < TILE_STATS_BUCKETS; ++i) {
+		copyBuckets_[i] = 0;
+		uploadBuckets_[i] = 0;
+	}
+	lastSampleMs_ = 0;
+	lastReceived_ = 0;
+	lastRendered_ = 0;
+	lastDropped_ = 0;
+	lastCopyUs_ = 0;
+	lastUploadUs_ = 0;
+}
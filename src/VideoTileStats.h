@@ -0,0 +1,73 @@
+#ifndef VIDEOTILESTATS_H
+#define VIDEOTILESTATS_H
+
+#include <atomic>
+#include <cstdint>
+
+//copy and upload times are counted in buckets of this width, the last one holds the rest
+#define TILE_STATS_BUCKET_US 100
+#define TILE_STATS_BUCKETS 200
+
+//values shown by the tile HUD, refreshed once per second
+typedef struct tagVideoTileSnapshot
+{
+	float receivedFps = 0.0f;
+	float renderedFps = 0.0f;
+	float copyMs = 0.0f;
+	float uploadMs = 0.0f;
+	//frames overwritten before they were rendered, per second like the rates
+	float droppedFps = 0.0f;
+	int frameWidth = 0;
+	int frameHeight = 0;
+}VideoTileSnapshot;
+
+//counters since the last Reset, percentiles at bucket resolution
+typedef struct tagVideoTileTotals
+{
+	unsigned int received = 0;
+	unsigned int rendered = 0;
+	unsigned int dropped = 0;
+	int64_t copyUs = 0;
+	int64_t uploadUs = 0;
+	float copyP50Ms = 0.0f;
+	float copyP95Ms = 0.0f;
+	float copyP99Ms = 0.0f;
+	float uploadP50Ms = 0.0f;
+	float uploadP95Ms = 0.0f;
+	float uploadP99Ms = 0.0f;
+}VideoTileTotals;
+
+// Lock free frame counters of one VideoWidget.
+// OnFrameCopied is called from the SDK video thread (CopyVideoFrame),
+// OnFrameRendered and Sample from the GUI thread (paintGL / hud timer).
+class VideoTileStats
+{
+public:
+	VideoTileStats();
+	void OnFrameCopied(int width, int height, int64_t copyUs, bool overwritten);
+	void OnFrameRendered(int64_t uploadUs);
+	bool Sample(int64_t nowMs, VideoTileSnapshot& snapshot);
+	//whole run, read once the frames stopped coming
+	VideoTileTotals Totals() const;
+	void Reset();
+private:
+	std::atomic<unsigned int> received_;
+	std::atomic<unsigned int> rendered_;
+	std::atomic<unsigned int> dropped_;
+	std::atomic<int64_t> copyUs_;
+	std::atomic<int64_t> uploadUs_;
+	std::atomic<int> frameWidth_;
+	std::atomic<int> frameHeight_;
+	std::atomic<unsigned int> copyBuckets_[TILE_STATS_BUCKETS];
+	std::atomic<unsigned int> uploadBuckets_[TILE_STATS_BUCKETS];
+
+	//only touched by Sample
+	int64_t lastSampleMs_ = 0;
+	unsigned int lastReceived_ = 0;
+	unsigned int lastRendered_ = 0;
+	unsigned int lastDropped_ = 0;
+	int64_t lastCopyUs_ = 0;
+	int64_t lastUploadUs_ = 0;
+};
+
+#endif // VIDEOTILESTATS_H
@@ -0,0 +1,294 @@
+#include "VideoTileView.h"
+#include <QTransform>
+#include <algorithm>
+#include <chrono>
+
+//frames are uploaded as they are when the tile is at least this fraction of them
+#define DOWNSCALE_BYPASS_SCALE 0.75f
+
+static std::atomic<bool> g_hudVisible(false);
+static std::atomic<bool> g_downscaleEnabled(true);
+static std::atomic<int> g_renderQuality(RENDER_QUALITY_AUTO);
+
+static int64_t NowUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//size the frame is scaled to before upload, false when it is uploaded as is
+static bool ScaledFrameSize(const agora::media::base::VideoFrame& frame, int tileWidth, int tileHeight, int& width, int& height)
+{
+	if (tileWidth <= 0 || tileHeight <= 0 || frame.width <= 0 || frame.height <= 0)
+		return false;
+	if (frame.rotation == 90 || frame.rotation == 270)
+		std::swap(tileWidth, tileHeight);
+	//cover the tile, the cropping render mode must not have to magnify
+	float scale = (std::max)((float)tileWidth / frame.width, (float)tileHeight / frame.height);
+	if (scale >= DOWNSCALE_BYPASS_SCALE)
+		return false;
+	width = (std::max)(2, (int)(frame.width * scale + 1.0f) & ~1);
+	height = (std::max)(2, (int)(frame.height * scale + 1.0f) & ~1);
+	return true;
+}
+
+VideoTileView::VideoTileView(float rate, QWidget *parent)
+	:QOpenGLWidget(parent)
+	, rate_(rate)
+	, m_tileWidth(0)
+	, m_tileHeight(0)
+{
+	//renderer and frame buffers are created by the first frame, see paintGL and CopyVideoFrame
+	//the hud timer only runs while the tile paints with the hud on
+	hudTimer_ = new QTimer(this);
+	hudTimer_->setInterval(1000);
+	connect(hudTimer_, &QTimer::timeout, this, &VideoTileView::onHudTimer);
+}
+
+VideoTileView::~VideoTileView()
+{
+	//gl objects of the renderer are freed in the tile context
+	if (m_render) {
+		makeCurrent();
+		m_render.reset();
+		doneCurrent();
+	}
+	ReleaseFrameBuffers();
+}
+
+void VideoTileView::ReleaseFrameBuffers()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	delete[] m_frame.yBuffer;
+	delete[] m_frame.uBuffer;
+	delete[] m_frame.vBuffer;
+	m_frame.yBuffer = nullptr;
+	m_frame.uBuffer = nullptr;
+	m_frame.vBuffer = nullptr;
+	m_lumaCapacity = 0;
+	m_chromaCapacity = 0;
+	m_hasFrame = false;
+	m_frameDirty = false;
+}
+
+bool VideoTileView::HasResources()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_render != nullptr || m_lumaCapacity != 0;
+}
+
+//planes of m_frame are packed, grow them for frames above 4K
+void VideoTileView::EnsureFrameBuffers(int width, int height)
+{
+	size_t luma = (size_t)width * height;
+	size_t chroma = (size_t)chromaSize(width) * chromaSize(height);
+	if (luma <= m_lumaCapacity && chroma <= m_chromaCapacity)
+		return;
+	delete[] m_frame.yBuffer;
+	delete[] m_frame.uBuffer;
+	delete[] m_frame.vBuffer;
+	m_frame.yBuffer = new uint8_t[luma];
+	m_frame.uBuffer = new uint8_t[chroma];
+	m_frame.vBuffer = new uint8_t[chroma];
+	m_frame.type = agora::media::base::VIDEO_PIXEL_I420;
+	m_lumaCapacity = luma;
+	m_chromaCapacity = chroma;
+}
+
+void VideoTileView::initializeGL()
+{
+}
+
+void VideoTileView::resizeGL(int w, int h)
+{
+	if (m_render)
+		m_render->setSize(w * rate_ , h * rate_ + 1);
+	m_tileWidth = w * rate_;
+	m_tileHeight = h * rate_;
+}
+
+void VideoTileView::paintGL()
+{
+	bool drawn = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (CanRender() && render && m_hasFrame) {
+			//shaders and textures wait for the first frame of a stream
+			if (!m_render)
+				m_render = std::make_unique<VideoRendererOpenGL>(m_tileWidth, m_tileHeight + 1);
+			if (!m_render->isInitialized())
+				m_render->initialize(m_tileWidth, m_tileHeight + 1);
+			//rotation comes with every frame, the renderer only reacts to changes
+			m_render->setFrameInfo(m_frame.rotation);
+			m_render->setColorInfo(m_frameColor);
+			m_render->setRenderQuality(g_renderQuality);
+			m_render->setGpuTimingEnabled(g_hudVisible);
+			int64_t start = NowUs();
+			m_render->renderFrame(m_frame);
+			if (m_frameDirty)
+				m_stats.OnFrameRendered(NowUs() - start);
+			m_frameDirty = false;
+			drawn = true;
+		}
+		else
+			OnVideoHidden();
+	}
+
+	if (drawn && g_hudVisible) {
+		if (!hudTimer_->isActive()) {
+			//restarts the sampling window, this sample covers the time the hud was off
+			m_stats.Sample(NowUs() / 1000, m_snapshot);
+			hudTimer_->start();
+		}
+		float gpuMs = m_render->gpuTimeMs();
+		QString hud = QString("%1x%2 %10\nrecv %3 fps\nrender %4 fps\ncopy %5 ms\nupload %6 ms\ndropped %7 fps\ngpu %8 ms (%9)")
+			.arg(m_snapshot.frameWidth).arg(m_snapshot.frameHeight)
+			.arg(m_snapshot.receivedFps, 0, 'f', 1)
+			.arg(m_snapshot.renderedFps, 0, 'f', 1)
+			.arg(m_snapshot.copyMs, 0, 'f', 2)
+			.arg(m_snapshot.uploadMs, 0, 'f', 2)
+			.arg(m_snapshot.droppedFps, 0, 'f', 1)
+			.arg(gpuMs < 0 ? QString("-") : QString::number(gpuMs, 'f', 2))
+			.arg(VideoRendererOpenGL::qualityName(m_render->activeQuality()))
+			.arg(colorInfoName(m_render->colorInfo()));
+		m_render->renderHud(this, hud + HudExtra());
+	}
+}
+
+void VideoTileView::onHudTimer()
+{
+	if (!g_hudVisible) {
+		hudTimer_->stop();
+		return;
+	}
+	if (m_stats.Sample(NowUs() / 1000, m_snapshot) && render)
+		update();
+}
+
+void VideoTileView::SetHudVisible(bool visible)
+{
+	g_hudVisible = visible;
+}
+
+bool VideoTileView::IsHudVisible()
+{
+	return g_hudVisible;
+}
+
+void VideoTileView::SetDownscaleEnabled(bool enabled)
+{
+	g_downscaleEnabled = enabled;
+}
+
+bool VideoTileView::IsDownscaleEnabled()
+{
+	return g_downscaleEnabled;
+}
+
+void VideoTileView::SetRenderQuality(int quality)
+{
+	g_renderQuality = quality;
+}
+
+int VideoTileView::RenderQuality()
+{
+	return g_renderQuality;
+}
+
+bool VideoTileView::HandleDebugKey(int key)
+{
+	switch (key) {
+	case Qt::Key_F3:
+		SetHudVisible(!IsHudVisible());
+		break;
+	case Qt::Key_F4:
+		SetDownscaleEnabled(!IsDownscaleEnabled());
+		break;
+	case Qt::Key_F5:
+		//compare the gpu time on the hud
+		SetRenderQuality((RenderQuality() + 1) % (RENDER_QUALITY_AUTO + 1));
+		break;
+	default:
+		return false;
+	}
+	return true;
+}
+
+void VideoTileView::ResetFrame()
+{
+	render = false;
+	hudTimer_->stop();
+	m_stats.Reset();
+	m_snapshot = VideoTileSnapshot();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_hasFrame = false;
+}
+
+void VideoTileView::CopyVideoFrame(agora::media::base::VideoFrame& videoFrame, const VideoColorInfo& color)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	int64_t start = NowUs();
+	m_frameColor = color;
+
+	int width = 0;
+	int height = 0;
+	if (g_downscaleEnabled && ScaledFrameSize(videoFrame, m_tileWidth, m_tileHeight, width, height)) {
+		//small tiles, upload only what the tile can show
+		EnsureFrameBuffers(width, height);
+		scaleI420Frame(videoFrame, m_frame, width, height, m_scaleScratch);
+	}
+	else {
+		//visible rows only, packed so the renderer uploads each plane at once
+		EnsureFrameBuffers(videoFrame.width, videoFrame.height);
+		copyI420Frame(videoFrame, m_frame);
+	}
+	m_stats.OnFrameCopied(videoFrame.width, videoFrame.height, NowUs() - start, m_frameDirty);
+	m_frameDirty = true;
+	m_hasFrame = true;
+}
+
+bool VideoTileView::GrabFrame(int width, int height, QImage& image)
+{
+	if (width <= 0 || height <= 0)
+		return false;
+	int rotation = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_hasFrame)
+			return false;
+		//scale in the orientation of the stored frame, rotate the small result
+		rotation = m_frame.rotation;
+		if (rotation == 90 || rotation == 270)
+			std::swap(width, height);
+		agora::media::base::VideoFrame view;
+		coverCropI420Frame(m_frame, width, height, view);
+
+		size_t luma = (size_t)width * height;
+		size_t chroma = (size_t)chromaSize(width) * chromaSize(height);
+		m_grabPlanes.resize(luma + 2 * chroma);
+		agora::media::base::VideoFrame scaled;
+		scaled.yBuffer = m_grabPlanes.data();
+		scaled.uBuffer = m_grabPlanes.data() + luma;
+		scaled.vBuffer = m_grabPlanes.data() + luma + chroma;
+		scaleI420Frame(view, scaled, width, height, m_scaleScratch);
+
+		image = QImage(width, height, QImage::Format_RGBA8888);
+		convertI420ToRgba(scaled, m_frameColor, image.bits(), image.bytesPerLine());
+	}
+	if (rotation != 0)
+		image = image.transformed(QTransform().rotate(rotation));
+	return true;
+}
+
+bool VideoTileView::HasPendingFrame()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_frameDirty;
+}
+
+void VideoTileView::renderFrame()
+{
+	OnVideoShown();
+	render = true;
+	update();
+}
@@ -0,0 +1,101 @@
+#ifndef VIDEOTILEVIEW_H
+#define VIDEOTILEVIEW_H
+
+#include <QOpenGLWidget>
+#include <QImage>
+#include <QString>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "video_render_opengl.h"
+#include "VideoTileStats.h"
+#include "video_frame_copy.h"
+
+// OpenGL tile of one stream: frames are copied in from any thread, drawn by
+// paintGL and counted for the HUD. Needs no sdk library and no ui, so
+// FrameReplay uses it as is; VideoWidget adds the user name and buttons.
+class VideoTileView : public QOpenGLWidget
+{
+	Q_OBJECT
+
+public:
+	VideoTileView(float rate, QWidget *parent = 0);
+	~VideoTileView();
+	void SetRate(float rate) { rate_ = rate; }
+	void CopyVideoFrame(agora::media::base::VideoFrame& videoFrame, const VideoColorInfo& color);
+	//latest frame cropped and scaled to width x height, any thread
+	bool GrabFrame(int width, int height, QImage& image);
+	//frees the frame planes of an idle tile, the next frame allocates them again
+	void ReleaseFrameBuffers();
+	//renderer or frame planes are allocated
+	bool HasResources();
+	//tile statistics of the last second, as shown on the hud
+	VideoTileSnapshot TileSnapshot() const { return m_snapshot; }
+	//tile statistics since the last ResetFrame
+	VideoTileTotals TileTotals() const { return m_stats.Totals(); }
+	//a copied frame waits for paintGL
+	bool HasPendingFrame();
+	static void SetHudVisible(bool visible);
+	static bool IsHudVisible();
+	//scale frames down to the tile size on the cpu before upload, on by default
+	static void SetDownscaleEnabled(bool enabled);
+	static bool IsDownscaleEnabled();
+	//RENDER_QUALITY of all tiles, RENDER_QUALITY_AUTO by default
+	static void SetRenderQuality(int quality);
+	static int RenderQuality();
+	//F3 hud, F4 downscale, F5 render quality of all tiles; true when the key was one
+	//of them, the dialog then repaints its tiles
+	static bool HandleDebugKey(int key);
+public slots:
+	//a new frame was copied, schedules the paint
+	void renderFrame();
+protected:
+	virtual void initializeGL() override;
+	virtual void resizeGL(int w, int h) override;
+	virtual void paintGL() override;
+	//called under the frame lock, false keeps the tile on its background
+	virtual bool CanRender() const { return true; }
+	//paintGL had nothing to draw, or renderFrame got the first frame
+	virtual void OnVideoHidden() {}
+	virtual void OnVideoShown() {}
+	//more lines of the hud
+	virtual QString HudExtra() const { return QString(); }
+	//drops the frame and the statistics, the tile waits for the next renderFrame
+	void ResetFrame();
+
+	float rate_ = 1.0f;
+private:
+	void EnsureFrameBuffers(int width, int height);
+	void onHudTimer();
+
+	//created by the first painted frame
+	std::unique_ptr<VideoRendererOpenGL> m_render;
+	std::mutex m_mutex;
+	//usage of m_frame should be guarded by m_mutex
+
+	bool render = false;
+	//pixel size of the tile, written by resizeGL and read by CopyVideoFrame
+	std::atomic<int> m_tileWidth;
+	std::atomic<int> m_tileHeight;
+	agora::media::base::VideoFrame m_frame;
+	//yuv matrix and range of m_frame
+	VideoColorInfo m_frameColor;
+	//bytes allocated for the packed planes of m_frame
+	size_t m_lumaCapacity = 0;
+	size_t m_chromaCapacity = 0;
+	FrameScaleScratch m_scaleScratch;
+	//i420 planes of GrabFrame
+	std::vector<uint8_t> m_grabPlanes;
+	//a frame was copied since the last ResetFrame
+	bool m_hasFrame = false;
+	//set by CopyVideoFrame, cleared by paintGL; guarded by m_mutex
+	bool m_frameDirty = false;
+
+	VideoTileStats m_stats;
+	VideoTileSnapshot m_snapshot;
+	QTimer* hudTimer_ = nullptr;
+};
+
+#endif // VIDEOTILEVIEW_H
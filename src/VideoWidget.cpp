@@ -1,79 +1,61 @@
 ﻿#include "VideoWidget.h"
 #include<qstyleditemdelegate.h>
 #include "AgoraRtcEngine.h"
+
 VideoWidget::VideoWidget(float initRate, float rate, QWidget *parent)
-	:QOpenGLWidget(parent)
-	, m_rotation(0)
+	: VideoTileView(rate, parent)
 	, initRate_(initRate)
-	, rate_(rate)
 {
 	userInfo.uid = 0;
 	userInfo.name = "";
 	ui.setupUi(this);
 	InitWidget();
-
-	m_render = std::make_unique<VideoRendererOpenGL>(  widgetW, widgetH);
-
-	
-	InitVideoFrame();
 }
 
 VideoWidget::~VideoWidget()
 {
-	delete[] m_frame.yBuffer;
-	delete[] m_frame.uBuffer;
-	delete[] m_frame.vBuffer;
-	m_frame.yBuffer = nullptr;
-	m_frame.uBuffer = nullptr;
-	m_frame.vBuffer = nullptr;
 }
 
-void VideoWidget::InitVideoFrame()
+void VideoWidget::resizeGL(int w, int h)
 {
-	m_frame.yStride = 3840;
-	m_frame.uStride = 1920;
-	m_frame.vStride = 1920;
-	m_frame.width = 3840;
-	m_frame.height = 2160;
-	m_frame.yBuffer = new uint8_t[m_frame.yStride * m_frame.height];
-	m_frame.uBuffer = new uint8_t[m_frame.uStride * m_frame.height / 2];
-	m_frame.vBuffer = new uint8_t[m_frame.vStride * m_frame.height / 2];
-	memset(m_frame.yBuffer, 0, m_frame.yStride * m_frame.height);
-	memset(m_frame.uBuffer, 128, m_frame.uStride * m_frame.height / 2);
-	memset(m_frame.vBuffer, 128, m_frame.vStride * m_frame.height / 2);
-	m_frame.type = agora::media::base::VIDEO_PIXEL_I420;
+	VideoTileView::resizeGL(w, h);
+	ui.widgetFrame->setGeometry(0, 0, w , h);
+	ui.verticalLayoutWidget->setGeometry(0, 0, w, h);
 }
 
-void VideoWidget::initializeGL()
+bool VideoWidget::CanRender() const
 {
+	return (userInfo.uid != 0 || preview_) && !muteVideo;
 }
 
-void VideoWidget::resizeGL(int w, int h)
+void VideoWidget::OnVideoHidden()
 {
-	m_render->setSize(w * rate_ , h * rate_ + 1);
-	ui.widgetFrame->setGeometry(0, 0, w , h);
-	ui.verticalLayoutWidget->setGeometry(0, 0, w, h);
+	if (!ui.widgetFrame->isVisible())
+		ui.widgetFrame->show();
 }
 
-void VideoWidget::paintGL()
+void VideoWidget::OnVideoShown()
 {
-	if (!m_render)
-		return;
+	if (ui.widgetFrame->isVisible())
+		ui.widgetFrame->hide();
+}
 
-	if (!m_render->isInitialized()) {
-		m_render->initialize(widgetW, widgetH);
-	}
+QString VideoWidget::HudExtra() const
+{
+	if (userInfo.uid == 0 || userInfo.uid != setting.userInfo2.uid)
+		return QString();
+	PlayerMetrics player = rtcEngine->Player()->Metrics();
+	return QString("\nplayer open %1 ms, play %2 ms\nbuffer %3 ms, stalls %4")
+		.arg(player.openMs).arg(player.playMs).arg(player.bufferMs).arg(player.stalls);
+}
 
-	{
-		std::lock_guard<std::mutex> lock(m_mutex);
-		m_render->setFrameInfo(m_rotation);
-		if (userInfo.uid != 0  && !muteVideo && render) {
-			m_render->renderFrame(m_frame);
-		}
-		else if(!ui.widgetFrame->isVisible()){
-			ui.widgetFrame->show();
-		}
-	}
+void VideoWidget::SetPreview(bool preview)
+{
+	preview_ = preview;
+	btnUser->setVisible(!preview);
+	btnCamera->setVisible(!preview);
+	btnMic->setVisible(!preview);
+	btnFullScreen->setVisible(!preview);
 }
 
 void VideoWidget::SetUserInfo(UserInfo info)
@@ -99,40 +81,11 @@ void VideoWidget::Reset()
 	muteAudio = false;
 	muteVideo = false;
 	fullScreen = false;
-	render = false;
+	ResetFrame();
 	SetCameraButtonStats(muteVideo);
 	SetMicButtonStats(muteAudio);
 }
 
-void VideoWidget::CopyVideoFrame(agora::media::base::VideoFrame& videoFrame)
-{
-	std::lock_guard<std::mutex> lock(m_mutex);
-	m_render->setFrameInfo(m_rotation);
-	m_frame.yStride = videoFrame.yStride;
-	m_frame.uStride = videoFrame.uStride;
-	m_frame.vStride = videoFrame.vStride;
-	m_frame.width = videoFrame.width;
-	m_frame.height = videoFrame.height;
-	m_frame.rotation = videoFrame.rotation;
-	m_frame.avsync_type = videoFrame.avsync_type;
-	m_frame.renderTimeMs = videoFrame.renderTimeMs;
-	m_frame.type = videoFrame.type;
-	if(m_frame.yBuffer)
-	memcpy(m_frame.yBuffer, videoFrame.yBuffer, videoFrame.yStride * videoFrame.height);
-	if(m_frame.uBuffer)
-	memcpy(m_frame.uBuffer, videoFrame.uBuffer, videoFrame.uStride * videoFrame.height / 2);
-	if(m_frame.vBuffer)
-	memcpy(m_frame.vBuffer, videoFrame.vBuffer, videoFrame.vStride * videoFrame.height / 2);
-}
-
-void VideoWidget::renderFrame()
-{
-	if (ui.widgetFrame->isVisible())
-		ui.widgetFrame->hide();
-	render = true;
-	update();
-}
-
 void VideoWidget::on_btnCamera_clicked()
 {
 	if (userInfo.uid == 0)
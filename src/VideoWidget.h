@@ -4,13 +4,11 @@
 #include<QWidget>
 #include<QFrame>
 #include <QPushButton>
-#include <QOpenGLWidget>
 #include "ui_VideoWidget.h"
 #include "SettingsData.h"
-#include "video_render_opengl.h"
-#include <memory>
-#include <mutex>
-class VideoWidget: public QOpenGLWidget
+#include "VideoTileView.h"
+//tile of the video rooms: the user name and the mute and full screen buttons over a VideoTileView
+class VideoWidget: public VideoTileView
 {
 	friend class AgoraRtcEngine;
 	Q_OBJECT
@@ -18,19 +16,24 @@ class VideoWidget: public QOpenGLWidget
 public:
 	VideoWidget(float initRate, float rate, QWidget *parent = 0);
 	~VideoWidget();
-	void SetRate(float rate) { rate_ = rate; }
-	virtual void initializeGL() override;
-	virtual void resizeGL(int w, int h) override;
-	virtual void paintGL() override;
 	void SetUserInfo(UserInfo info); 
 	void SetWidgetInfo(WidgetInfo info);
-	void CopyVideoFrame(agora::media::base::VideoFrame& videoFrame);
 	unsigned int GetUID() { return userInfo.uid; }
 	void UpdateButtonPos();
 	void RestoreWidget();
 	void MaximizeWidget(int w, int h);
+	void SetTileGeometry(const QRect& rc);
 	void Reset();
 	bool IsMax() { return bMax; }
+	//local camera preview of the settings dialog, no uid and no buttons
+	void SetPreview(bool preview);
+protected:
+	virtual void resizeGL(int w, int h) override;
+	virtual bool CanRender() const override;
+	virtual void OnVideoHidden() override;
+	virtual void OnVideoShown() override;
+	//media player metrics on the tile of video source 2
+	virtual QString HudExtra() const override;
 private:
 	Ui::VideoWidget ui;
 	QPushButton* btnUser;
@@ -46,19 +49,14 @@ private:
 	int btnW = 48;
 	int btnSpacing = 16;
 	int btnPadding = 20;
-	float rate_ = 1.0f;
-
-	std::unique_ptr<VideoRendererOpenGL> m_render;
-	std::mutex m_mutex;
-	//usage of m_frame should be guarded by m_mutex
-	int m_rotation;
+	//border radius in the btnUser sheet
+	int userRadius_ = -1;
 
 	UserInfo userInfo;
 	bool muteAudio = false;
 	bool muteVideo = false;
 	bool fullScreen = false;
-	bool render = false;
-	agora::media::base::VideoFrame m_frame;
+	bool preview_ = false;
 
 	void InitButton();
 	
@@ -66,7 +64,6 @@ private:
 	void SetCameraButtonStats(bool mute);
 	void SetFullScreenButtonStats(bool full);
 	void InitWidget(); 
-	void InitVideoFrame();
 
 	float initRate_ = 1.0f;
 	//DPI_TYPE dpiType_ = DPI_1080;
@@ -74,7 +71,6 @@ private slots:
 	void on_btnCamera_clicked();
 	void on_btnMic_clicked();
 	void on_btnFullScreen_clicked();
-	void renderFrame();
 signals:
 	void fullScreenSignal(unsigned int uid, bool bFull);
 	void muteVideoSignal(unsigned int uid, bool bMute);
@@ -7,13 +7,17 @@
 #include "DlgExtend.h"
 #include "DlgInfo.h"
 #include <QScreen>
+#include <QDebug>
 #include "AgoraRtcEngine.h"
+#include "StartupTrace.h"
 
 AgoraCourse::AgoraCourse(QWidget* parent)
 	: QRoundCornerDialog(parent)
 {
 	ui.setupUi(this);
 	InitDlg();
+	roomRate_ = rate;
+	roomRate2_ = rate2;
 	
 	QString appid = APP_ID;
 	if (appid.isEmpty())
@@ -29,7 +33,9 @@ AgoraCourse::AgoraCourse(QWidget* parent)
 		return;
 	}
 	else {
-		rtcEngine->Init();
+		connect(rtcEngine, &AgoraRtcEngine::engineReady,
+			this, &AgoraCourse::onEngineReady);
+		rtcEngine->InitAsync();
 	}
 	connect(rtcEngine, &AgoraRtcEngine::joinedChannelSuccess,
 		this, &AgoraCourse::onJoinChannelSuccess);
@@ -39,14 +45,43 @@ AgoraCourse::AgoraCourse(QWidget* parent)
 
 	ui.roomNameEdit->setText("dualteacher");
 	ui.userNameEdit->setText(QString::fromStdWString(L"老师123"));
+	startupMark("login dialog built");
+}
 
+void AgoraCourse::EnsureClassRoomDlgs()
+{
+	if (dlgRoom)
+		return;
 	dlgRoom = new DlgVideoRoom(this);
-	dlgExtend = new DlgExtend(rate, rate2, dlgRoom,this);
+	dlgExtend = new DlgExtend(roomRate_, roomRate2_, dlgRoom,this);
 	connect(dlgRoom, &DlgVideoRoom::closeRoom,
 		this, &AgoraCourse::onCloseRoom);
 
 	connect(dlgExtend, &DlgExtend::closeRoom,
 		this, &AgoraCourse::onCloseRoom);
+	startupMark("classroom dialogs built");
+}
+
+bool AgoraCourse::WaitEngine()
+{
+	int ret = rtcEngine->WaitInit();
+	if (ret == 0)
+		return true;
+	QString strInfo = QString::fromStdWString(L"引擎初始化失败:%1").arg(ret);
+	DlgInfo dlg(strInfo, rate, rate2);
+	connect(&dlg, &DlgInfo::parentMaxSignal,
+		this, &AgoraCourse::on_parentMax_slot);
+	if (!bMax && dlg.IsMax())
+		dlg.maxButtonChange(true);
+	dlg.exec();
+	return false;
+}
+
+void AgoraCourse::onEngineReady(int ret)
+{
+	startupMark("engine ready");
+	if (ret != 0)
+		qDebug() << "engine init failed:" << ret;
 }
 
 AgoraCourse::~AgoraCourse()
@@ -104,25 +139,39 @@ void AgoraCourse::on_loginButton_clicked()
 		return;
 	}
 	byteString = user_name.toUtf8();
+	//usually long done while the names were typed
+	if (!WaitEngine())
+		return;
+	//video source 2 is opened while the room is set up and plays once open
+	if (setting.enabledVideoSource2)
+		rtcEngine->Player()->Open(setting.videoSource2Url, true);
+	//before the joins, userJoined may follow joinedChannelSuccess immediately
+	EnsureClassRoomDlgs();
 	if (setting.userInfo.uid == 0) {
 		setting.userInfo.uid = randomUid();
 		setting.userInfo2.uid = setting.userInfo.uid + 1;
+		setting.userInfo3.uid = setting.userInfo.uid + 2;
+		setting.userInfo4.uid = setting.userInfo.uid + 3;
 	}
 	setting.userInfo.name = user_name;
 	setting.className = class_name;
 	setting.userInfo2.name = user_name;
+	setting.userInfo3.name = user_name;
+	setting.userInfo4.name = user_name;
 	setting.className = class_name;
 	agora::rtc::VideoEncoderConfiguration config;
 	config.dimensions.width = setting.resolution[setting.resIndex].width;
 	config.dimensions.height = setting.resolution[setting.resIndex].height;
 	config.frameRate = setting.frameRate;
 	rtcEngine->SetFecParameter(2);
-	bool subscribe = !setting.enabledVideoSource1;
 	if (setting.enabledVideoSource1)
 		rtcEngine->VideoSource1JoinChannel(setting.enabledVideoSource1, "", setting.className.toUtf8(), setting.userInfo.uid, config);
+	rtcEngine->SyncVideoSource(VIDEO_SOURCE_CAMERA_SECONDARY, setting.enabledVideoSource3, setting.className, setting.userInfo3.uid);
+	rtcEngine->SyncVideoSource(VIDEO_SOURCE_SCREEN, setting.enabledScreenShare, setting.className, setting.userInfo4.uid);
 	if (setting.enabledVideoSource2) {
-		int ret = rtcEngine->VideoSource2JoinChannel(true, "", setting.className.toUtf8(), setting.userInfo2.uid, subscribe, subscribe);
+		int ret = rtcEngine->VideoSource2JoinChannel(true, "", setting.className.toUtf8(), setting.userInfo2.uid);
 		if (ret != 0) {
+			rtcEngine->StopVideoSource2();
 			QString strInfo = QString::fromStdWString(L"视频源2加入房间失败:%1").arg(ret);
 			DlgInfo dlg(strInfo, rate, rate2);
 			connect(&dlg, &DlgInfo::parentMaxSignal,
@@ -146,7 +195,17 @@ unsigned int AgoraCourse::randomUid( )
 
 void AgoraCourse::onJoinChannelSuccess(const char* channel, agora::rtc::uid_t uid, int elapsed)
 {
-	rtcEngine->SetJoined(true);
+	//joined flag of video source 2 is set by on_loginButton_clicked,
+	//the other connections may join before video source 1
+	if (uid == setting.userInfo.uid)
+		rtcEngine->SetJoined(true);
+	else if (setting.enabledVideoSource1)
+		return;
+	static bool firstJoin = true;
+	if (firstJoin) {
+		firstJoin = false;
+		startupMark("first join");
+	}
 	showClassRoomDlg();
 	disconnect(rtcEngine, &AgoraRtcEngine::joinedChannelSuccess,
 		this, &AgoraCourse::onJoinChannelSuccess);
@@ -159,6 +218,7 @@ void AgoraCourse::onLeaveChannel()
 
 void AgoraCourse::showClassRoomDlg() 
 {
+	EnsureClassRoomDlgs();
 	if (setting.bExtend) {
 		connect(dlgExtend, &DlgExtend::parentMaxSignal,
 			this, &AgoraCourse::on_parentMax_slot);
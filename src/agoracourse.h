@@ -53,7 +53,15 @@ private:
 	void maxButtonChange(bool max);
 
 	unsigned int  randomUid(); // 1:teacher 2:student
+	//classroom dialogs are built on the first join, not with the login screen
+	void EnsureClassRoomDlgs();
+	//WaitInit, the error dialog when the engine failed to initialize
+	bool WaitEngine();
 	void showClassRoomDlg();
+	bool shown_ = false;
+	//rates at construction, the extend dialog is laid out from them
+	float roomRate_ = 1.0f;
+	float roomRate2_ = 1.0f;
 private slots :
 	void on_parentMax_slot(bool childMax);
 	void on_settingsButton_clicked();
@@ -62,6 +70,7 @@ private slots :
 	void on_closeButton_clicked();
 	void on_loginButton_clicked();
 	void onJoinChannelSuccess(const char* channel, agora::rtc::uid_t uid, int elapsed);
+	void onEngineReady(int ret);
 	
 	void onCloseRoom(bool bExtend);
 	void onLeaveChannel();
@@ -10,9 +10,12 @@
 #include "DlgSettings.h"
 #include "DlgSettingAudio.h"
 #include "DlgVideoRoom.h"
+#include "StartupTrace.h"
 int main(int argc, char *argv[])
 {
 	QApplication a(argc, argv);
+	startupMark("application");
+
 	AgoraCourse w;
 	w.show();
 
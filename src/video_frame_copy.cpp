@@ -0,0 +1,533 @@
+#include "video_frame_copy.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FRAME_COPY_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FRAME_COPY_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define FRAME_COPY_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+typedef void (*CopyRowFunc)(const uint8_t* src, uint8_t* dst, int width);
+
+void copyRowScalar(const uint8_t* src, uint8_t* dst, int width)
+{
+    memcpy(dst, src, width);
+}
+
+#if FRAME_COPY_X86
+void cpuId(int leaf, int subLeaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, leaf, subLeaf);
+    for (int i = 0; i < 4; ++i)
+        regs[i] = (unsigned int)info[i];
+#else
+    __cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// AVX2 also needs the os to save the ymm registers.
+bool osSupportsAvx()
+{
+    unsigned int regs[4];
+    cpuId(1, 0, regs);
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avx = (regs[2] & (1u << 28)) != 0;
+    if (!osxsave || !avx)
+        return false;
+#if defined(_MSC_VER)
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    unsigned long long xcr0 = ((unsigned long long)edx << 32) | eax;
+#endif
+    return (xcr0 & 0x6) == 0x6;
+}
+
+FRAME_COPY_KERNEL detectKernel()
+{
+    unsigned int regs[4];
+    cpuId(0, 0, regs);
+    unsigned int maxLeaf = regs[0];
+    if (maxLeaf >= 7 && osSupportsAvx()) {
+        cpuId(7, 0, regs);
+        if (regs[1] & (1u << 5))
+            return FRAME_COPY_AVX2;
+    }
+    cpuId(1, 0, regs);
+    if (regs[3] & (1u << 26))
+        return FRAME_COPY_SSE2;
+    return FRAME_COPY_SCALAR;
+}
+
+void copyRowSse2(const uint8_t* src, uint8_t* dst, int width)
+{
+    int x = 0;
+    for (; x + 64 <= width; x += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + x + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + x + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + x + 48));
+        _mm_storeu_si128((__m128i*)(dst + x), a);
+        _mm_storeu_si128((__m128i*)(dst + x + 16), b);
+        _mm_storeu_si128((__m128i*)(dst + x + 32), c);
+        _mm_storeu_si128((__m128i*)(dst + x + 48), d);
+    }
+    for (; x + 16 <= width; x += 16)
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_loadu_si128((const __m128i*)(src + x)));
+    if (x < width)
+        memcpy(dst + x, src + x, width - x);
+}
+
+// Streaming stores need an aligned destination, the packed rows are not.
+void copyRowSse2Stream(const uint8_t* src, uint8_t* dst, int width)
+{
+    int head = (int)((16 - ((uintptr_t)dst & 15)) & 15);
+    if (head > width)
+        head = width;
+    memcpy(dst, src, head);
+    int x = head;
+    for (; x + 64 <= width; x += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + x + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + x + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + x + 48));
+        _mm_stream_si128((__m128i*)(dst + x), a);
+        _mm_stream_si128((__m128i*)(dst + x + 16), b);
+        _mm_stream_si128((__m128i*)(dst + x + 32), c);
+        _mm_stream_si128((__m128i*)(dst + x + 48), d);
+    }
+    for (; x + 16 <= width; x += 16)
+        _mm_stream_si128((__m128i*)(dst + x), _mm_loadu_si128((const __m128i*)(src + x)));
+    if (x < width)
+        memcpy(dst + x, src + x, width - x);
+}
+
+FRAME_COPY_TARGET_AVX2 void copyRowAvx2(const uint8_t* src, uint8_t* dst, int width)
+{
+    int x = 0;
+    for (; x + 128 <= width; x += 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src + x));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + x + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(src + x + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(src + x + 96));
+        _mm256_storeu_si256((__m256i*)(dst + x), a);
+        _mm256_storeu_si256((__m256i*)(dst + x + 32), b);
+        _mm256_storeu_si256((__m256i*)(dst + x + 64), c);
+        _mm256_storeu_si256((__m256i*)(dst + x + 96), d);
+    }
+    for (; x + 32 <= width; x += 32)
+        _mm256_storeu_si256((__m256i*)(dst + x), _mm256_loadu_si256((const __m256i*)(src + x)));
+    if (x < width)
+        memcpy(dst + x, src + x, width - x);
+}
+
+FRAME_COPY_TARGET_AVX2 void copyRowAvx2Stream(const uint8_t* src, uint8_t* dst, int width)
+{
+    int head = (int)((32 - ((uintptr_t)dst & 31)) & 31);
+    if (head > width)
+        head = width;
+    memcpy(dst, src, head);
+    int x = head;
+    for (; x + 128 <= width; x += 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src + x));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + x + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(src + x + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(src + x + 96));
+        _mm256_stream_si256((__m256i*)(dst + x), a);
+        _mm256_stream_si256((__m256i*)(dst + x + 32), b);
+        _mm256_stream_si256((__m256i*)(dst + x + 64), c);
+        _mm256_stream_si256((__m256i*)(dst + x + 96), d);
+    }
+    for (; x + 32 <= width; x += 32)
+        _mm256_stream_si256((__m256i*)(dst + x), _mm256_loadu_si256((const __m256i*)(src + x)));
+    if (x < width)
+        memcpy(dst + x, src + x, width - x);
+}
+#endif
+
+typedef void (*HalveRowFunc)(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int dstWidth);
+typedef void (*BlendRowFunc)(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int width, int weight);
+
+// 2x2 box, dst[x] averages src columns 2x and 2x+1 of both rows.
+void halveRowScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int dstWidth)
+{
+    for (int x = 0; x < dstWidth; ++x)
+        dst[x] = (uint8_t)((row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1] + 2) >> 2);
+}
+
+// weight is the share of row1 in 1/256.
+void blendRowScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int width, int weight)
+{
+    int weight0 = 256 - weight;
+    for (int x = 0; x < width; ++x)
+        dst[x] = (uint8_t)((row0[x] * weight0 + row1[x] * weight + 128) >> 8);
+}
+
+#if FRAME_COPY_X86
+void halveRowSse2(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int dstWidth)
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    int x = 0;
+    for (; x + 16 <= dstWidth; x += 16) {
+        __m128i v0 = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(row0 + 2 * x)),
+            _mm_loadu_si128((const __m128i*)(row1 + 2 * x)));
+        __m128i v1 = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(row0 + 2 * x + 16)),
+            _mm_loadu_si128((const __m128i*)(row1 + 2 * x + 16)));
+        __m128i h0 = _mm_avg_epu16(_mm_and_si128(v0, mask), _mm_srli_epi16(v0, 8));
+        __m128i h1 = _mm_avg_epu16(_mm_and_si128(v1, mask), _mm_srli_epi16(v1, 8));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(h0, h1));
+    }
+    if (x < dstWidth)
+        halveRowScalar(row0 + 2 * x, row1 + 2 * x, dst + x, dstWidth - x);
+}
+
+void blendRowSse2(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int width, int weight)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(128);
+    const __m128i w0 = _mm_set1_epi16((short)(256 - weight));
+    const __m128i w1 = _mm_set1_epi16((short)weight);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(row0 + x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(row1 + x));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), w0),
+            _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w1));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), w0),
+            _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w1));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+    if (x < width)
+        blendRowScalar(row0 + x, row1 + x, dst + x, width - x, weight);
+}
+
+FRAME_COPY_TARGET_AVX2 void halveRowAvx2(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int dstWidth)
+{
+    const __m256i mask = _mm256_set1_epi16(0x00ff);
+    int x = 0;
+    for (; x + 32 <= dstWidth; x += 32) {
+        __m256i v0 = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i*)(row0 + 2 * x)),
+            _mm256_loadu_si256((const __m256i*)(row1 + 2 * x)));
+        __m256i v1 = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i*)(row0 + 2 * x + 32)),
+            _mm256_loadu_si256((const __m256i*)(row1 + 2 * x + 32)));
+        __m256i h0 = _mm256_avg_epu16(_mm256_and_si256(v0, mask), _mm256_srli_epi16(v0, 8));
+        __m256i h1 = _mm256_avg_epu16(_mm256_and_si256(v1, mask), _mm256_srli_epi16(v1, 8));
+        // packus works per 128 bit lane, restore the column order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(h0, h1), 0xd8);
+        _mm256_storeu_si256((__m256i*)(dst + x), packed);
+    }
+    if (x < dstWidth)
+        halveRowSse2(row0 + 2 * x, row1 + 2 * x, dst + x, dstWidth - x);
+}
+#endif
+
+HalveRowFunc selectHalveFunc(FRAME_COPY_KERNEL kernel)
+{
+#if FRAME_COPY_X86
+    if (kernel == FRAME_COPY_AVX2)
+        return halveRowAvx2;
+    if (kernel == FRAME_COPY_SSE2)
+        return halveRowSse2;
+#endif
+    return halveRowScalar;
+}
+
+// the vertical blend is memory bound, sse2 is used for avx2 as well
+BlendRowFunc selectBlendFunc(FRAME_COPY_KERNEL kernel)
+{
+#if FRAME_COPY_X86
+    if (kernel != FRAME_COPY_SCALAR)
+        return blendRowSse2;
+#endif
+    return blendRowScalar;
+}
+
+// Source position of a destination pixel, centers aligned, in 1/256.
+int sourcePosition(int dst, int srcSize, int dstSize)
+{
+    int64_t pos = ((int64_t)(2 * dst + 1) * srcSize * 256) / (2 * dstSize) - 128;
+    return pos < 0 ? 0 : (int)pos;
+}
+
+void scaleBilinear(const uint8_t* src, int srcStride, int srcWidth, int srcHeight,
+    uint8_t* dst, int dstWidth, int dstHeight, FrameScaleScratch& scratch)
+{
+    scratch.xIndex.resize(dstWidth);
+    scratch.xWeight.resize(dstWidth);
+    for (int x = 0; x < dstWidth; ++x) {
+        int pos = sourcePosition(x, srcWidth, dstWidth);
+        int index = pos >> 8;
+        int weight = pos & 0xff;
+        if (index >= srcWidth - 1) {
+            index = srcWidth - 1;
+            weight = 0;
+        }
+        scratch.xIndex[x] = index;
+        scratch.xWeight[x] = (uint8_t)weight;
+    }
+    // one extra column so index + 1 stays readable on the last pixel
+    scratch.row.resize(srcWidth + 1);
+    uint8_t* row = scratch.row.data();
+    BlendRowFunc blendRow = selectBlendFunc(frameCopyKernel());
+
+    for (int y = 0; y < dstHeight; ++y) {
+        int pos = sourcePosition(y, srcHeight, dstHeight);
+        int index = pos >> 8;
+        int weight = pos & 0xff;
+        if (index >= srcHeight - 1) {
+            index = srcHeight - 1;
+            weight = 0;
+        }
+        const uint8_t* row0 = src + (size_t)index * srcStride;
+        const uint8_t* row1 = weight ? row0 + srcStride : row0;
+        blendRow(row0, row1, row, srcWidth, weight);
+        row[srcWidth] = row[srcWidth - 1];
+
+        uint8_t* out = dst + (size_t)y * dstWidth;
+        for (int x = 0; x < dstWidth; ++x) {
+            const uint8_t* p = row + scratch.xIndex[x];
+            int w = scratch.xWeight[x];
+            out[x] = (uint8_t)((p[0] * (256 - w) + p[1] * w + 128) >> 8);
+        }
+    }
+}
+
+CopyRowFunc selectRowFunc(FRAME_COPY_KERNEL kernel, bool stream)
+{
+#if FRAME_COPY_X86
+    if (kernel == FRAME_COPY_AVX2)
+        return stream ? copyRowAvx2Stream : copyRowAvx2;
+    if (kernel == FRAME_COPY_SSE2)
+        return stream ? copyRowSse2Stream : copyRowSse2;
+#endif
+    return copyRowScalar;
+}
+
+} // namespace
+
+FRAME_COPY_KERNEL frameCopyKernel()
+{
+#if FRAME_COPY_X86
+    static const FRAME_COPY_KERNEL kernel = detectKernel();
+    return kernel;
+#else
+    return FRAME_COPY_SCALAR;
+#endif
+}
+
+const char* frameCopyKernelName(FRAME_COPY_KERNEL kernel)
+{
+    switch (kernel) {
+    case FRAME_COPY_AVX2:
+        return "avx2";
+    case FRAME_COPY_SSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+void copyPlane(const uint8_t* src, int srcStride, uint8_t* dst, int width, int height)
+{
+    if (!src || !dst || width <= 0 || height <= 0)
+        return;
+    // a padding free source is one contiguous block
+    if (srcStride == width) {
+        width *= height;
+        height = 1;
+    }
+    bool stream = (size_t)width * height >= FRAME_COPY_NT_THRESHOLD;
+    FRAME_COPY_KERNEL kernel = frameCopyKernel();
+    CopyRowFunc copyRow = selectRowFunc(kernel, stream);
+    for (int y = 0; y < height; ++y)
+        copyRow(src + (size_t)y * srcStride, dst + (size_t)y * width, width);
+#if FRAME_COPY_X86
+    // streaming stores are weakly ordered, publish them before the frame is handed to the gui
+    if (stream && kernel != FRAME_COPY_SCALAR)
+        _mm_sfence();
+#endif
+}
+
+void copyI420Frame(const agora::media::base::VideoFrame& src, agora::media::base::VideoFrame& dst)
+{
+    int width = src.width;
+    int height = src.height;
+    int uvWidth = chromaSize(width);
+    int uvHeight = chromaSize(height);
+    copyPlane(src.yBuffer, src.yStride, dst.yBuffer, width, height);
+    copyPlane(src.uBuffer, src.uStride, dst.uBuffer, uvWidth, uvHeight);
+    copyPlane(src.vBuffer, src.vStride, dst.vBuffer, uvWidth, uvHeight);
+
+    dst.yStride = width;
+    dst.uStride = uvWidth;
+    dst.vStride = uvWidth;
+    dst.width = width;
+    dst.height = height;
+    dst.rotation = src.rotation;
+    dst.avsync_type = src.avsync_type;
+    dst.renderTimeMs = src.renderTimeMs;
+    dst.type = src.type;
+}
+
+void scalePlaneDown(const uint8_t* src, int srcStride, int srcWidth, int srcHeight,
+    uint8_t* dst, int dstWidth, int dstHeight, FrameScaleScratch& scratch)
+{
+    if (!src || !dst || srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0)
+        return;
+
+    // halves ping-pong inside scratch.planes, the second one is a quarter of the first
+    size_t half = (size_t)(srcWidth / 2) * (srcHeight / 2);
+    if (scratch.planes.size() < half + half / 4 + 1)
+        scratch.planes.resize(half + half / 4 + 1);
+    uint8_t* buffers[2] = { scratch.planes.data(), scratch.planes.data() + half };
+    HalveRowFunc halveRow = selectHalveFunc(frameCopyKernel());
+
+    const uint8_t* cur = src;
+    int curStride = srcStride;
+    int curWidth = srcWidth;
+    int curHeight = srcHeight;
+    int which = 0;
+    while (curWidth >= 2 * dstWidth && curHeight >= 2 * dstHeight) {
+        int width = curWidth / 2;
+        int height = curHeight / 2;
+        bool last = (width == dstWidth && height == dstHeight);
+        uint8_t* out = last ? dst : buffers[which];
+        for (int y = 0; y < height; ++y)
+            halveRow(cur + (size_t)2 * y * curStride, cur + (size_t)(2 * y + 1) * curStride, out + (size_t)y * width, width);
+        if (last)
+            return;
+        cur = out;
+        curStride = width;
+        curWidth = width;
+        curHeight = height;
+        which ^= 1;
+    }
+
+    if (curWidth == dstWidth && curHeight == dstHeight)
+        copyPlane(cur, curStride, dst, dstWidth, dstHeight);
+    else
+        scaleBilinear(cur, curStride, curWidth, curHeight, dst, dstWidth, dstHeight, scratch);
+}
+
+void scaleI420Frame(const agora::media::base::VideoFrame& src, agora::media::base::VideoFrame& dst,
+    int dstWidth, int dstHeight, FrameScaleScratch& scratch)
+{
+    int uvWidth = chromaSize(dstWidth);
+    int uvHeight = chromaSize(dstHeight);
+    scalePlaneDown(src.yBuffer, src.yStride, src.width, src.height, dst.yBuffer, dstWidth, dstHeight, scratch);
+    scalePlaneDown(src.uBuffer, src.uStride, chromaSize(src.width), chromaSize(src.height), dst.uBuffer, uvWidth, uvHeight, scratch);
+    scalePlaneDown(src.vBuffer, src.vStride, chromaSize(src.width), chromaSize(src.height), dst.vBuffer, uvWidth, uvHeight, scratch);
+
+    dst.yStride = dstWidth;
+    dst.uStride = uvWidth;
+    dst.vStride = uvWidth;
+    dst.width = dstWidth;
+    dst.height = dstHeight;
+    dst.rotation = src.rotation;
+    dst.avsync_type = src.avsync_type;
+    dst.renderTimeMs = src.renderTimeMs;
+    dst.type = src.type;
+}
+
+const char* colorInfoName(const VideoColorInfo& color)
+{
+    if (color.matrix == VIDEO_COLOR_BT709)
+        return color.fullRange ? "709 full" : "709";
+    return color.fullRange ? "601 full" : "601";
+}
+
+void yuvToRgbCoefficients(const VideoColorInfo& color, float matrix[9], float offset[3])
+{
+    float kr = 0.299f;
+    float kb = 0.114f;
+    if (color.matrix == VIDEO_COLOR_BT709) {
+        kr = 0.2126f;
+        kb = 0.0722f;
+    }
+    float kg = 1.0f - kr - kb;
+    // limited range: Y in [16, 235], U/V in [16, 240]
+    float ys = color.fullRange ? 1.0f : 255.0f / 219.0f;
+    float cs = color.fullRange ? 1.0f : 255.0f / 224.0f;
+
+    matrix[0] = ys;
+    matrix[1] = 0.0f;
+    matrix[2] = cs * 2.0f * (1.0f - kr);
+    matrix[3] = ys;
+    matrix[4] = -cs * 2.0f * (1.0f - kb) * kb / kg;
+    matrix[5] = -cs * 2.0f * (1.0f - kr) * kr / kg;
+    matrix[6] = ys;
+    matrix[7] = cs * 2.0f * (1.0f - kb);
+    matrix[8] = 0.0f;
+
+    offset[0] = color.fullRange ? 0.0f : 16.0f / 255.0f;
+    offset[1] = 128.0f / 255.0f;
+    offset[2] = 128.0f / 255.0f;
+}
+
+void coverCropI420Frame(const agora::media::base::VideoFrame& src, int width, int height,
+    agora::media::base::VideoFrame& view)
+{
+    view = src;
+    if (width <= 0 || height <= 0 || src.width <= 0 || src.height <= 0)
+        return;
+    int cropWidth = src.width;
+    int cropHeight = src.height;
+    if ((int64_t)src.width * height > (int64_t)src.height * width)
+        cropWidth = (std::max)(2, (int)((int64_t)src.height * width / height) & ~1);
+    else
+        cropHeight = (std::max)(2, (int)((int64_t)src.width * height / width) & ~1);
+    int x = ((src.width - cropWidth) / 2) & ~1;
+    int y = ((src.height - cropHeight) / 2) & ~1;
+    view.yBuffer = src.yBuffer + (size_t)y * src.yStride + x;
+    view.uBuffer = src.uBuffer + (size_t)(y / 2) * src.uStride + x / 2;
+    view.vBuffer = src.vBuffer + (size_t)(y / 2) * src.vStride + x / 2;
+    view.width = (std::min)(cropWidth, src.width);
+    view.height = (std::min)(cropHeight, src.height);
+}
+
+void convertI420ToRgba(const agora::media::base::VideoFrame& src, const VideoColorInfo& color,
+    uint8_t* dst, int dstStride)
+{
+    float matrix[9];
+    float offset[3];
+    yuvToRgbCoefficients(color, matrix, offset);
+    // 12 bit fixed point, the offsets are whole code values
+    int coef[9];
+    for (int i = 0; i < 9; ++i)
+        coef[i] = (int)(matrix[i] * 4096.0f + (matrix[i] < 0 ? -0.5f : 0.5f));
+    int yOffset = (int)(offset[0] * 255.0f + 0.5f);
+
+    for (int y = 0; y < src.height; ++y) {
+        const uint8_t* yRow = src.yBuffer + (size_t)y * src.yStride;
+        const uint8_t* uRow = src.uBuffer + (size_t)(y / 2) * src.uStride;
+        const uint8_t* vRow = src.vBuffer + (size_t)(y / 2) * src.vStride;
+        uint8_t* out = dst + (size_t)y * dstStride;
+        for (int x = 0; x < src.width; ++x) {
+            int luma = (yRow[x] - yOffset) * coef[0] + 2048;
+            int u = uRow[x / 2] - 128;
+            int v = vRow[x / 2] - 128;
+            int r = (luma + coef[2] * v) >> 12;
+            int g = (luma + coef[4] * u + coef[5] * v) >> 12;
+            int b = (luma + coef[7] * u) >> 12;
+            out[0] = (uint8_t)(r < 0 ? 0 : (r > 255 ? 255 : r));
+            out[1] = (uint8_t)(g < 0 ? 0 : (g > 255 ? 255 : g));
+            out[2] = (uint8_t)(b < 0 ? 0 : (b > 255 ? 255 : b));
+            out[3] = 255;
+            out += 4;
+        }
+    }
+}
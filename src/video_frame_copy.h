@@ -0,0 +1,92 @@
+#ifndef VIDEO_FRAME_COPY_H
+#define VIDEO_FRAME_COPY_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "IAgoraMediaEngine.h"
+
+// Plane copy kernels used by VideoWidget::CopyVideoFrame.
+// Only the visible width of each row is copied and the destination is
+// tightly packed (stride == width), so the renderer can upload every
+// plane with a single glTexSubImage2D call.
+enum FRAME_COPY_KERNEL
+{
+    FRAME_COPY_SCALAR = 0,
+    FRAME_COPY_SSE2,
+    FRAME_COPY_AVX2
+};
+
+// Planes of at least this many bytes are written with non-temporal
+// stores so they do not evict the cache of the sdk decode threads.
+#define FRAME_COPY_NT_THRESHOLD (1024 * 1024)
+
+// Best kernel of the running cpu, detected once.
+FRAME_COPY_KERNEL frameCopyKernel();
+const char* frameCopyKernelName(FRAME_COPY_KERNEL kernel);
+
+// I420 chroma planes are rounded up for odd sizes.
+inline int chromaSize(int size) { return (size + 1) / 2; }
+
+void copyPlane(const uint8_t* src, int srcStride, uint8_t* dst, int width, int height);
+
+// Copies the visible part of an I420 frame into the buffers of dst.
+// dst buffers must hold width*height and chromaSize(width)*chromaSize(height)
+// bytes; strides, size and metadata of dst are updated.
+void copyI420Frame(const agora::media::base::VideoFrame& src, agora::media::base::VideoFrame& dst);
+
+// YUV interpretation of a frame. The sdk VideoFrame carries none, so it is
+// passed next to the frame from DeliverVideoFrame to the renderer. Local
+// cameras take theirs from the video settings, remote streams use the
+// BT.601 limited range default; capture files keep theirs.
+enum VIDEO_COLOR_MATRIX
+{
+    VIDEO_COLOR_BT601 = 0,
+    VIDEO_COLOR_BT709
+};
+
+struct VideoColorInfo
+{
+    int matrix = VIDEO_COLOR_BT601;
+    bool fullRange = false;
+
+    bool operator==(const VideoColorInfo& other) const
+    {
+        return matrix == other.matrix && fullRange == other.fullRange;
+    }
+    bool operator!=(const VideoColorInfo& other) const { return !(*this == other); }
+};
+
+const char* colorInfoName(const VideoColorInfo& color);
+
+// rgb = matrix * (yuv - offset) with yuv in [0, 1], matrix is row major.
+void yuvToRgbCoefficients(const VideoColorInfo& color, float matrix[9], float offset[3]);
+
+// Intermediate buffers of the downscaler, kept by the caller between frames.
+struct FrameScaleScratch
+{
+    std::vector<uint8_t> planes;
+    std::vector<uint8_t> row;
+    std::vector<int> xIndex;
+    std::vector<uint8_t> xWeight;
+};
+
+// Scales one plane down into a packed dstWidth x dstHeight plane.
+// 2x2 box halving runs while the plane is at least twice the target,
+// a bilinear pass then lands on the exact size.
+void scalePlaneDown(const uint8_t* src, int srcStride, int srcWidth, int srcHeight,
+    uint8_t* dst, int dstWidth, int dstHeight, FrameScaleScratch& scratch);
+
+// Same as copyI420Frame but the result is dstWidth x dstHeight.
+void scaleI420Frame(const agora::media::base::VideoFrame& src, agora::media::base::VideoFrame& dst,
+    int dstWidth, int dstHeight, FrameScaleScratch& scratch);
+
+// Points view at the centered part of src with the aspect of
+// width x height, nothing is copied. Offsets stay even for the chroma planes.
+void coverCropI420Frame(const agora::media::base::VideoFrame& src, int width, int height,
+    agora::media::base::VideoFrame& view);
+
+// Converts an I420 frame to RGBA8888 of the same size, rows are dstStride bytes.
+void convertI420ToRgba(const agora::media::base::VideoFrame& src, const VideoColorInfo& color,
+    uint8_t* dst, int dstStride);
+
+#endif // VIDEO_FRAME_COPY_H
@@ -1,16 +1,30 @@
 #include "video_render_opengl.h"
+#include "video_frame_copy.h"
 //#include "video_render_impl.h"
 #include <QOpenGLContext>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLFunctions>
+#include <QOpenGLTimerQuery>
+#include <QPainter>
 #include <QDebug>
+#include <algorithm>
 
 using namespace agora::media;
 
 static const char g_indices[] = { 0, 3, 2, 0, 2, 1 };
 
+static int normalizeRotation(int rotation)
+{
+    return ((rotation % 360) + 360) % 360;
+}
+
 VideoRendererOpenGL::VideoRendererOpenGL(int width, int height)
     :m_program(nullptr)
+    ,m_positionHandle(-1)
+    ,m_textureHandle(-1)
+    ,m_vertexBuffer(QOpenGLBuffer::VertexBuffer)
+    ,m_indexBuffer(QOpenGLBuffer::IndexBuffer)
+    ,m_planValid(false)
     ,m_zOrder(0)
     ,m_left(1)
     ,m_top(0)
@@ -21,36 +35,35 @@ VideoRendererOpenGL::VideoRendererOpenGL(int width, int height)
     ,m_textureHeight(-1)
     ,m_targetWidth(width)
     ,m_targetHeight(height)
-    ,m_resetGlVert(true)
     ,m_rotation(0)
-    ,m_mirrored(true)
-{
- /*   static const GLfloat vertices[20] = {
-      // X, Y, Z, U, V
-      -1, -1, 0, 1, 0, // Bottom Left
-      1, -1, 0, 0, 0, //Bottom Right
-      1, 1, 0, 0, 1, //Top Right
-      -1, 1, 0, 1, 1 }; //Top Left*/
-	static const GLfloat vertices[20] = {
-		// X, Y, Z, U, V
-		-1, 1, 0, 1, 1 , //Top Left
-		1, 1, 0, 0, 1 //Top Right
-		-1, -1, 0, 1, 0, // Bottom Left
-		1, -1, 0, 0, 0, //Bottom Right
-		
-	}; 
-
+    ,m_mirrored(false)
+    ,m_transformRotation(-1)
+    ,m_transformMirrored(false)
+    ,m_colorUploaded(false)
+    ,m_quality(RENDER_QUALITY_AUTO)
+    ,m_activeQuality(RENDER_QUALITY_LINEAR)
+    ,m_gpuTiming(false)
+    ,m_gpuTimerPending(false)
+    ,m_gpuTimerRunning(false)
+    ,m_gpuTimerSupported(true)
+    ,m_gpuTimer(nullptr)
+    ,m_gpuTimeMs(-1.0f)
+{
     memset(m_textureIds, 0, sizeof(m_textureIds));
-    memcpy(m_vertices, vertices, sizeof(m_vertices));
+    memset(m_plan.vertices, 0, sizeof(m_plan.vertices));
 }
 
 VideoRendererOpenGL::~VideoRendererOpenGL()
 {
 //    qDebug() << "video renderer " << this << " destroyed";
+    // the owner makes its context current; without one the objects go with the context
+    if (!QOpenGLContext::currentContext())
+        return;
     if (m_textureIds[0] != 0) {
-        //QOpenGLFunctions *f = renderer();
-        //f->glDeleteTextures(3, m_textureIds);
+        QOpenGLFunctions *f = renderer();
+        f->glDeleteTextures(3, m_textureIds);
     }
+    cleanup();
 }
 
 void VideoRendererOpenGL::cleanup()
@@ -60,6 +73,14 @@ void VideoRendererOpenGL::cleanup()
         delete m_program;
         m_program = nullptr;
     }
+    delete m_gpuTimer;
+    m_gpuTimer = nullptr;
+    m_transformRotation = -1;
+    m_colorUploaded = false;
+    m_vao.destroy();
+    m_vertexBuffer.destroy();
+    m_indexBuffer.destroy();
+    m_planValid = false;
 }
 
 int VideoRendererOpenGL::setStreamProperties(int zOrder, float left, float top, float right, float bottom)
@@ -69,6 +90,7 @@ int VideoRendererOpenGL::setStreamProperties(int zOrder, float left, float top,
     m_top = top;
     m_right = right;
     m_bottom = bottom;
+    m_planValid = false;
     return 0;
 }
 
@@ -82,13 +104,11 @@ int VideoRendererOpenGL::getStreamProperties(int& zOrder, float& left, float& to
     return 0;
 }
 
-void VideoRendererOpenGL::setFrameInfo(int rotation)
+// rotation, size and mode are only recorded, drawPlan picks the change up
+void VideoRendererOpenGL::setFrameInfo(int rotation, bool mirrored)
 {
-    if (m_rotation != rotation)
-    {
-        m_resetGlVert = true;
-        m_rotation = rotation;
-    }
+    m_rotation = normalizeRotation(rotation);
+    m_mirrored = mirrored;
 }
 
 void VideoRendererOpenGL::setRenderMode(int mode)
@@ -96,6 +116,29 @@ void VideoRendererOpenGL::setRenderMode(int mode)
 	m_renderMode = mode;
 }
 
+const char* VideoRendererOpenGL::qualityName(int quality)
+{
+    switch (quality) {
+    case RENDER_QUALITY_NEAREST:
+        return "nearest";
+    case RENDER_QUALITY_LINEAR:
+        return "linear";
+    case RENDER_QUALITY_MIPMAP:
+        return "mipmap";
+    default:
+        return "auto";
+    }
+}
+
+static GLint minFilter(int quality)
+{
+    if (quality == RENDER_QUALITY_MIPMAP)
+        return GL_LINEAR_MIPMAP_LINEAR;
+    if (quality == RENDER_QUALITY_LINEAR)
+        return GL_LINEAR;
+    return GL_NEAREST;
+}
+
 inline QOpenGLFunctions* VideoRendererOpenGL::renderer()
 {
     return QOpenGLContext::currentContext()->functions();
@@ -106,37 +149,26 @@ QOpenGLShaderProgram* VideoRendererOpenGL::createProgram()
     static const char vertextShader[] = {
       "attribute vec4 aPosition;\n"
       "attribute vec2 aTextureCoord;\n"
+      "uniform mat2 uTexTransform;\n"
       "varying vec2 vTextureCoord;\n"
       "void main() {\n"
       "  gl_Position = aPosition;\n"
-      "  vTextureCoord = aTextureCoord;\n"
+      "  vTextureCoord = uTexTransform * (aTextureCoord - 0.5) + 0.5;\n"
       "}\n" };
 
     // The fragment shader.
-    // Do YUV to RGB565 conversion.
+    // YUV to RGB with the matrix and offsets of the stream's VideoColorInfo.
     static const char fragmentShader[] = {
-      "mediump float;\n"
       "uniform sampler2D Ytex;\n"
       "uniform sampler2D Utex,Vtex;\n"
+      "uniform mat3 uYuvToRgb;\n"
+      "uniform vec3 uYuvOffset;\n"
       "varying vec2 vTextureCoord;\n"
       "void main(void) {\n"
-      "  float nx,ny,r,g,b,y,u,v;\n"
-      "  mediump vec4 txl,ux,vx;"
-      "  nx=vTextureCoord[0];\n"
-      "  ny=vTextureCoord[1];\n"
-      "  y=texture2D(Ytex,vec2(nx,ny)).r;\n"
-      "  u=texture2D(Utex,vec2(nx,ny)).r;\n"
-      "  v=texture2D(Vtex,vec2(nx,ny)).r;\n"
-
-      //"  y = v;\n"+
-      "  y=1.1643*(y-0.0625);\n"
-      "  u=u-0.5;\n"
-      "  v=v-0.5;\n"
-
-      "  r=y+1.5958*v;\n"
-      "  g=y-0.39173*u-0.81290*v;\n"
-      "  b=y+2.017*u;\n"
-      "  gl_FragColor=vec4(r,g,b,1.0);\n"
+      "  vec3 yuv = vec3(texture2D(Ytex, vTextureCoord).r,\n"
+      "                  texture2D(Utex, vTextureCoord).r,\n"
+      "                  texture2D(Vtex, vTextureCoord).r);\n"
+      "  gl_FragColor = vec4(uYuvToRgb * (yuv - uYuvOffset), 1.0);\n"
       "}\n" };
 
     QOpenGLShaderProgram* program = new QOpenGLShaderProgram;
@@ -151,137 +183,200 @@ int VideoRendererOpenGL::initialize(int width, int height)
     if (m_program)
         return 0;
     m_program = createProgram();
+    m_positionHandle = m_program->attributeLocation("aPosition");
+    m_textureHandle = m_program->attributeLocation("aTextureCoord");
+
+    // samplers never change, set them once
+    m_program->bind();
+    m_program->setUniformValue("Ytex", 0);
+    m_program->setUniformValue("Utex", 1);
+    m_program->setUniformValue("Vtex", 2);
+    m_program->release();
+
+    initializeBuffers();
     setSize(width, height);
     return 0;
 }
 
+// Indices are static, the vertex buffer is filled by drawPlan.
+// The attribute layout is recorded in a VAO when the context has them.
+void VideoRendererOpenGL::initializeBuffers()
+{
+    m_vertexBuffer.create();
+    m_vertexBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    m_vertexBuffer.bind();
+    m_vertexBuffer.allocate(sizeof(m_plan.vertices));
+
+    m_indexBuffer.create();
+    m_indexBuffer.bind();
+    m_indexBuffer.allocate(g_indices, sizeof(g_indices));
+
+    if (m_vao.create()) {
+        m_vao.bind();
+        m_vertexBuffer.bind();
+        m_indexBuffer.bind();
+        bindVertexAttribs();
+        m_vao.release();
+    }
+    m_vertexBuffer.release();
+    m_indexBuffer.release();
+    m_planValid = false;
+}
+
 void VideoRendererOpenGL::setSize(int width, int height)
 {
     m_targetWidth = width;
     m_targetHeight = height;
-	m_resetGlVert = true;//fit
 }
 
-int VideoRendererOpenGL::prepare(int frameWidth, int frameHeight)
+const DrawPlan& VideoRendererOpenGL::drawPlan(int frameWidth, int frameHeight)
 {
-    if (!m_program)
-        return -1;
-
-    int positionHandle = m_program->attributeLocation("aPosition");
-    if (positionHandle == -1)
-        return -1;
-
-    int textureHandle = m_program->attributeLocation("aTextureCoord");
-    if (textureHandle == -1) {
-        return -1;
-    }
+    if (m_planValid && m_plan.matches(frameWidth, frameHeight, m_targetWidth, m_targetHeight, m_rotation, m_renderMode))
+        return m_plan;
+
+    m_plan.frameWidth = frameWidth;
+    m_plan.frameHeight = frameHeight;
+    m_plan.targetWidth = m_targetWidth;
+    m_plan.targetHeight = m_targetHeight;
+    m_plan.rotation = m_rotation;
+    m_plan.renderMode = m_renderMode;
+    ajustVertices(m_plan);
+
+    m_vertexBuffer.bind();
+    m_vertexBuffer.write(0, m_plan.vertices, sizeof(m_plan.vertices));
+    m_vertexBuffer.release();
+    m_planValid = true;
+    return m_plan;
+}
 
+// 4 vertices of 5 floats, xyz for the position and uv for the texture
+void VideoRendererOpenGL::bindVertexAttribs()
+{
     QOpenGLFunctions *f = renderer();
-    // set the vertices array in the shader
-    // _vertices contains 4 vertices with 5 coordinates.
-    // 3 for (xyz) for the vertices and 2 for the texture
-    f->glVertexAttribPointer(positionHandle, 3, GL_FLOAT, false,
-                          5 * sizeof(GLfloat), m_vertices);
-
-    f->glEnableVertexAttribArray(positionHandle);
-
-    // set the texture coordinate array in the shader
-    // _vertices contains 4 vertices with 5 coordinates.
-    // 3 for (xyz) for the vertices and 2 for the texture
-    f->glVertexAttribPointer(textureHandle, 2, GL_FLOAT, false, 5
-                          * sizeof(GLfloat), &m_vertices[3]);
-    f->glEnableVertexAttribArray(textureHandle);
-
-    m_program->bind();
-
-    int i = m_program->uniformLocation("Ytex");
-    f->glUniform1i(i, 0); /* Bind Ytex to texture unit 0 */
-
-    i = m_program->uniformLocation("Utex");
-    f->glUniform1i(i, 1); /* Bind Utex to texture unit 1 */
-
-    i = m_program->uniformLocation("Vtex");
-    f->glUniform1i(i, 2); /* Bind Vtex to texture unit 2 */
-
-
- 
-    f->glViewport(0, 0, m_targetWidth, m_targetHeight);
-
-    return 0;
+    f->glVertexAttribPointer(m_positionHandle, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), nullptr);
+    f->glEnableVertexAttribArray(m_positionHandle);
+    f->glVertexAttribPointer(m_textureHandle, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat),
+        reinterpret_cast<const void*>(3 * sizeof(GLfloat)));
+    f->glEnableVertexAttribArray(m_textureHandle);
 }
 
-int VideoRendererOpenGL::applyVertices()
-    {
-    if (!m_program)
-        return -1;
-
-    int positionHandle = m_program->attributeLocation("aPosition");
-    if (positionHandle == -1) {
-        return -1;
+// Uniforms are program state and survive the HUD painter, the matrix is
+// only sent when rotation or mirroring changes.
+void VideoRendererOpenGL::updateTexTransform()
+{
+    if (m_transformRotation == m_rotation && m_transformMirrored == m_mirrored)
+        return;
+    // clockwise rotation of the displayed image around the texture center
+    float c = 1.0f;
+    float s = 0.0f;
+    if (m_rotation == 90) {
+        c = 0.0f;
+        s = 1.0f;
     }
-
-    int textureHandle = m_program->attributeLocation("aTextureCoord");
-    if (textureHandle == -1) {
-        return -1;
+    else if (m_rotation == 180) {
+        c = -1.0f;
     }
+    else if (m_rotation == 270) {
+        c = 0.0f;
+        s = -1.0f;
+    }
+    // mirroring flips the displayed x of the rotated image, mirrored=false is upright
+    float m = m_mirrored ? -1.0f : 1.0f;
+    const float values[4] = {
+        c * m, s,
+        -s * m, c };
+    m_program->setUniformValue("uTexTransform", QMatrix2x2(values));
+    m_transformRotation = m_rotation;
+    m_transformMirrored = m_mirrored;
+}
 
-    QOpenGLFunctions *f = renderer();
-
-    // set the vertices array in the shader
-    // _vertices contains 4 vertices with 5 coordinates.
-    // 3 for (xyz) for the vertices and 2 for the texture
-    f->glVertexAttribPointer(positionHandle, 3, GL_FLOAT, false,
-                        5 * sizeof(GLfloat), m_vertices);
-
-    f->glEnableVertexAttribArray(positionHandle);
-
-    // set the texture coordinate array in the shader
-    // _vertices contains 4 vertices with 5 coordinates.
-    // 3 for (xyz) for the vertices and 2 for the texture
-    f->glVertexAttribPointer(textureHandle, 2, GL_FLOAT, false, 5
-                        * sizeof(GLfloat), &m_vertices[3]);
-
-    f->glEnableVertexAttribArray(textureHandle);
+// Same caching as uTexTransform, streams only switch matrix on a new source.
+void VideoRendererOpenGL::updateColorTransform()
+{
+    if (m_colorUploaded && m_uploadedColor == m_color)
+        return;
+    float matrix[9];
+    float offset[3];
+    yuvToRgbCoefficients(m_color, matrix, offset);
+    m_program->setUniformValue("uYuvToRgb", QMatrix3x3(matrix));
+    m_program->setUniformValue("uYuvOffset", offset[0], offset[1], offset[2]);
+    m_uploadedColor = m_color;
+    m_colorUploaded = true;
+}
 
-    return 0;
+// The HUD QPainter shares the context and resets program, buffers and
+// attribute arrays on end(), so the few binds are redone per frame.
+void VideoRendererOpenGL::bindState()
+{
+    m_program->bind();
+    if (m_vao.isCreated()) {
+        m_vao.bind();
+    }
+    else {
+        m_vertexBuffer.bind();
+        m_indexBuffer.bind();
+        bindVertexAttribs();
+    }
+    renderer()->glViewport(0, 0, m_targetWidth, m_targetHeight);
 }
 
 int VideoRendererOpenGL::renderFrame(const agora::media::base::VideoFrame& videoFrame)
 {
-	int r = prepare(videoFrame.width, videoFrame.height);
-    if (r)
-        return r;
+    if (!m_program || m_positionHandle == -1 || m_textureHandle == -1)
+        return -1;
 
     QOpenGLFunctions *f = renderer();
 
-    f->glClear(GL_COLOR_BUFFER_BIT);
-
+    beginGpuTimer();
     if (m_textureWidth != (GLsizei) videoFrame.width ||
         m_textureHeight != (GLsizei) videoFrame.height)
     {
         setupTextures(videoFrame);
-        m_resetGlVert = true;
     }
 
-    if (m_resetGlVert)
-    {
-        if (!ajustVertices())
-            m_resetGlVert = false;
-    }
+    int quality = selectQuality();
+    if (quality != m_activeQuality)
+        applyQuality(quality);
+
+    // steady state: cached plan, texture upload and one draw
+    drawPlan(videoFrame.width, videoFrame.height);
+    bindState();
+    updateTexTransform();
+    updateColorTransform();
+    f->glClear(GL_COLOR_BUFFER_BIT);
 
     updateTextures(videoFrame);
+    if (m_activeQuality == RENDER_QUALITY_MIPMAP)
+        generateMipmaps();
 
-    f->glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, g_indices);
+    f->glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, nullptr);
+    if (m_vao.isCreated())
+        m_vao.release();
+    endGpuTimer();
 
     return 0;
 }
 
+void VideoRendererOpenGL::renderHud(QPaintDevice* device, const QString& text)
+{
+    QPainter painter(device);
+    QFont font = painter.font();
+    font.setPixelSize(12);
+    painter.setFont(font);
+    QRect rc = painter.fontMetrics().boundingRect(QRect(0, 0, 400, 400), Qt::AlignLeft | Qt::AlignTop, text);
+    //bottom left, the user name button sits at the top left
+    rc.moveTo(8, device->height() - rc.height() - 8);
+    painter.fillRect(rc.adjusted(-4, -4, 4, 4), QColor(0, 0, 0, 160));
+    painter.setPen(Qt::green);
+    painter.drawText(rc, Qt::AlignLeft | Qt::AlignTop, text);
+}
+
 void VideoRendererOpenGL::initializeTexture(int name, int id, int width, int height)
 {
     QOpenGLFunctions *f = renderer();
     f->glActiveTexture(name);
     f->glBindTexture(GL_TEXTURE_2D, id);
-    f->glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter(m_activeQuality));
     f->glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     f->glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     f->glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -289,6 +384,78 @@ void VideoRendererOpenGL::initializeTexture(int name, int id, int width, int hei
                GL_LUMINANCE, GL_UNSIGNED_BYTE, NULL);
 }
 
+// Texture to viewport scale decides the filter, mipmaps only pay off
+// once the texture is minified by more than 2.
+int VideoRendererOpenGL::selectQuality() const
+{
+    if (m_quality != RENDER_QUALITY_AUTO)
+        return m_quality;
+    if (m_textureWidth <= 0 || m_textureHeight <= 0)
+        return RENDER_QUALITY_LINEAR;
+    int r = m_rotation;
+    int frWidth = (r == 90 || r == 270) ? m_textureHeight : m_textureWidth;
+    int frHeight = (r == 90 || r == 270) ? m_textureWidth : m_textureHeight;
+    float scale = (std::min)((float)m_targetWidth / frWidth, (float)m_targetHeight / frHeight);
+    return scale < 0.5f ? RENDER_QUALITY_MIPMAP : RENDER_QUALITY_LINEAR;
+}
+
+void VideoRendererOpenGL::applyQuality(int quality)
+{
+    m_activeQuality = quality;
+    if (!m_textureIds[0])
+        return;
+    QOpenGLFunctions *f = renderer();
+    for (int i = 0; i < 3; ++i) {
+        f->glActiveTexture(GL_TEXTURE0 + i);
+        f->glBindTexture(GL_TEXTURE_2D, m_textureIds[i]);
+        f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter(quality));
+    }
+}
+
+// Levels are rebuilt from every upload, the textures stay bound from updateTextures.
+void VideoRendererOpenGL::generateMipmaps()
+{
+    QOpenGLFunctions *f = renderer();
+    for (int i = 0; i < 3; ++i) {
+        f->glActiveTexture(GL_TEXTURE0 + i);
+        f->glBindTexture(GL_TEXTURE_2D, m_textureIds[i]);
+        f->glGenerateMipmap(GL_TEXTURE_2D);
+    }
+}
+
+// One query in flight, its result is collected without stalling on a later frame.
+void VideoRendererOpenGL::beginGpuTimer()
+{
+    if (m_gpuTimerPending && m_gpuTimer->isResultAvailable()) {
+        float ms = m_gpuTimer->waitForResult() / 1000000.0f;
+        m_gpuTimeMs = m_gpuTimeMs < 0 ? ms : m_gpuTimeMs * 0.9f + ms * 0.1f;
+        m_gpuTimerPending = false;
+    }
+    if (!m_gpuTiming || !m_gpuTimerSupported || m_gpuTimerPending)
+        return;
+    if (!m_gpuTimer) {
+        m_gpuTimer = new QOpenGLTimerQuery;
+        if (!m_gpuTimer->create()) {
+            qDebug() << "gpu timer queries are not supported";
+            delete m_gpuTimer;
+            m_gpuTimer = nullptr;
+            m_gpuTimerSupported = false;
+            return;
+        }
+    }
+    m_gpuTimer->begin();
+    m_gpuTimerPending = true;
+    m_gpuTimerRunning = true;
+}
+
+void VideoRendererOpenGL::endGpuTimer()
+{
+    if (!m_gpuTimerRunning)
+        return;
+    m_gpuTimer->end();
+    m_gpuTimerRunning = false;
+}
+
 void VideoRendererOpenGL::setupTextures(const agora::media::base::VideoFrame& frameToRender)
 {
     const GLsizei width = frameToRender.width;
@@ -299,8 +466,8 @@ void VideoRendererOpenGL::setupTextures(const agora::media::base::VideoFrame& fr
     if (!m_textureIds[0])
         f->glGenTextures(3, m_textureIds); //Generate  the Y, U and V texture
     initializeTexture(GL_TEXTURE0, m_textureIds[0], width, height);
-    initializeTexture(GL_TEXTURE1, m_textureIds[1], width / 2, height / 2);
-    initializeTexture(GL_TEXTURE2, m_textureIds[2], width / 2, height / 2);
+    initializeTexture(GL_TEXTURE1, m_textureIds[1], chromaSize(width), chromaSize(height));
+    initializeTexture(GL_TEXTURE2, m_textureIds[2], chromaSize(width), chromaSize(height));
 
     m_textureWidth = width;
     m_textureHeight = height;
@@ -312,17 +479,19 @@ void VideoRendererOpenGL::updateTextures(const agora::media::base::VideoFrame& v
     const GLsizei height = videoFrame.height;
 
     QOpenGLFunctions *f = renderer();
+    // packed rows of odd widths are not 4 byte aligned
+    f->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     f->glActiveTexture(GL_TEXTURE0);
     f->glBindTexture(GL_TEXTURE_2D, m_textureIds[0]);
     glTexSubImage2D(width, height, videoFrame.yStride, videoFrame.yBuffer);
 
     f->glActiveTexture(GL_TEXTURE1);
     f->glBindTexture(GL_TEXTURE_2D, m_textureIds[1]);
-    glTexSubImage2D(width / 2, height / 2, videoFrame.uStride, videoFrame.uBuffer);
+    glTexSubImage2D(chromaSize(width), chromaSize(height), videoFrame.uStride, videoFrame.uBuffer);
 	
     f->glActiveTexture(GL_TEXTURE2);
     f->glBindTexture(GL_TEXTURE_2D, m_textureIds[2]);
-    glTexSubImage2D(width / 2, height / 2, videoFrame.vStride, videoFrame.vBuffer);
+    glTexSubImage2D(chromaSize(width), chromaSize(height), videoFrame.vStride, videoFrame.vBuffer);
 
 }
 
@@ -350,118 +519,49 @@ void VideoRendererOpenGL::glTexSubImage2D(GLsizei width, GLsizei height, int str
     }
 }
 
-//rotation
-int VideoRendererOpenGL::ajustVertices()
+// Texture coordinates stay those of an upright frame, rotation and mirroring
+// are applied by uTexTransform. Only the letterbox depends on the rotation.
+int VideoRendererOpenGL::ajustVertices(DrawPlan& plan)
 {
   if (m_left < -90) {
     return -1;
   }
 
-  int r = m_rotation;
-  r = r < 0 ? r+360:r;
-
-//  qDebug() << "rotation " << r;
-
-  //adjust U/V
-  if (r == 270)//90)
-  {
-    //bottom left
-    m_vertices[3] = 0;
-    m_vertices[4] = 0;
+  int r = normalizeRotation(plan.rotation);
 
-    //bottom right
-    m_vertices[8] = 0;
-    m_vertices[9] = 1;
+  //bottom left
+  plan.vertices[3] = 0;
+  plan.vertices[4] = 1;
 
-    //top right
-    m_vertices[13] = 1;
-    m_vertices[14] = 1;
+  //bottom right
+  plan.vertices[8] = 1;
+  plan.vertices[9] = 1;
 
-    //top left
-    m_vertices[18] = 1;
-    m_vertices[19] = 0;
-  }
-  else if (r == 0)//180)
-  {
-    //bottom left
-      m_vertices[3] = m_mirrored ? 1 : 0;//0;
-    m_vertices[4] = 1;
-
-    //bottom right
-    m_vertices[8] = m_mirrored ? 0 : 1;
-    m_vertices[9] = 1;
-
-    //top right
-    m_vertices[13] = m_mirrored ? 0 : 1;
-    m_vertices[14] = 0;
-
-    //top left
-    m_vertices[18] = m_mirrored ? 1 : 0;
-    m_vertices[19] = 0;
-  }
-  else if (r == 90)//270)
-  {
-    //bottom left
-    m_vertices[3] = 0;
-    m_vertices[4] = 0;
+  //top right
+  plan.vertices[13] = 1;
+  plan.vertices[14] = 0;
 
-    //bottom right
-    m_vertices[8] = 0;
-    m_vertices[9] = 1;
+  //top left
+  plan.vertices[18] = 0;
+  plan.vertices[19] = 0;
 
-    //top right
-    m_vertices[13] = 1;
-    m_vertices[14] = 1;
-
-    //top left
-    m_vertices[18] = 1;
-    m_vertices[19] = 0;
-  }
-  else
-  {
-    //bottom left
-    m_vertices[3] = 1;
-    m_vertices[4] = 0;
-
-    //bottom right
-    m_vertices[8] = 0;
-    m_vertices[9] = 0;
-
-    //top right
-    m_vertices[13] = 0;
-    m_vertices[14] = 1;
-
-    //top left
-    m_vertices[18] = 1;
-    m_vertices[19] = 1;
-  }
-
-
-  if (m_left > m_right)
-  {
-      std::swap(m_vertices[3], m_vertices[8]);
-      std::swap(m_vertices[4], m_vertices[9]);
-      std::swap(m_vertices[13], m_vertices[18]);
-      std::swap(m_vertices[14], m_vertices[19]);
-  }
-
-  int renderMode = m_renderMode;
+  int renderMode = plan.renderMode;
 
   if ((r == 0 || r == 180))
   {
-    adjustCoordinates(m_textureWidth, m_textureHeight,
-      m_targetWidth, m_targetHeight, renderMode);
+    adjustCoordinates(plan, plan.frameWidth, plan.frameHeight,
+      plan.targetWidth, plan.targetHeight, renderMode);
   }
   else
   {
-    adjustCoordinates(m_textureHeight, m_textureWidth,
-      m_targetWidth, m_targetHeight, renderMode);
+    adjustCoordinates(plan, plan.frameHeight, plan.frameWidth,
+      plan.targetWidth, plan.targetHeight, renderMode);
   }
 
-  return applyVertices();
+  return 0;
 }
 
-int VideoRendererOpenGL::adjustCoordinates(int frWidth, int frHeight, int targetWidth, int targetHeight, int renderMode)
+int VideoRendererOpenGL::adjustCoordinates(DrawPlan& plan, int frWidth, int frHeight, int targetWidth, int targetHeight, int renderMode)
 {
   if (targetWidth <= 0 || targetHeight <= 0) {
     return 0;
@@ -481,7 +581,7 @@ int VideoRendererOpenGL::adjustCoordinates(int frWidth, int frHeight, int target
   top = m_top;
   bottom = m_bottom;
   
-  if (m_renderMode == 3) {
+  if (plan.renderMode == 3) {
     if (require_ratio*0.9 < orig_ratio && orig_ratio < require_ratio*1.1)
       renderMode = 1;
     else
@@ -523,24 +623,24 @@ int VideoRendererOpenGL::adjustCoordinates(int frWidth, int frHeight, int target
   }
 
   // Bottom Left
-  m_vertices[0] = (left * 2) - 1;
-  m_vertices[1] = -1 * (2 * bottom) + 1;
-  m_vertices[2] = zOrder;
+  plan.vertices[0] = (left * 2) - 1;
+  plan.vertices[1] = -1 * (2 * bottom) + 1;
+  plan.vertices[2] = zOrder;
 
   //Bottom Right
-  m_vertices[5] = (right * 2) - 1;
-  m_vertices[6] = -1 * (2 * bottom) + 1;
-  m_vertices[7] = zOrder;
+  plan.vertices[5] = (right * 2) - 1;
+  plan.vertices[6] = -1 * (2 * bottom) + 1;
+  plan.vertices[7] = zOrder;
 
   //Top Right
-  m_vertices[10] = (right * 2) - 1;
-  m_vertices[11] = -1 * (2 * top) + 1;
-  m_vertices[12] = zOrder;
+  plan.vertices[10] = (right * 2) - 1;
+  plan.vertices[11] = -1 * (2 * top) + 1;
+  plan.vertices[12] = zOrder;
 
   //Top Left
-  m_vertices[15] = (left * 2) - 1;
-  m_vertices[16] = -1 * (2 * top) + 1;
-  m_vertices[17] = zOrder;
+  plan.vertices[15] = (left * 2) - 1;
+  plan.vertices[16] = -1 * (2 * top) + 1;
+  plan.vertices[17] = zOrder;
 
   return 0;
 }
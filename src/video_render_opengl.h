@@ -1,11 +1,47 @@
 #ifndef VIDEORENDERER_OPENGL_H
 #define VIDEORENDERER_OPENGL_H
 #include <QOpenGLFunctions>
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include <QGenericMatrix>
 #include "IAgoraMediaEngine.h"
+#include "video_frame_copy.h"
 
 
 class AVideoWidget;
 class QOpenGLShaderProgram;
+class QOpenGLTimerQuery;
+class QPaintDevice;
+class QString;
+
+// Minification filter of the yuv textures. AUTO picks LINEAR or MIPMAP
+// from the scale between the texture and the viewport.
+enum RENDER_QUALITY
+{
+    RENDER_QUALITY_NEAREST = 0,
+    RENDER_QUALITY_LINEAR,
+    RENDER_QUALITY_MIPMAP,
+    RENDER_QUALITY_AUTO
+};
+
+// Geometry of one (frame size, target size, rotation, mode) combination.
+// It is rebuilt and uploaded to the vertex buffer only when the key changes.
+struct DrawPlan
+{
+    int frameWidth = 0;
+    int frameHeight = 0;
+    int targetWidth = 0;
+    int targetHeight = 0;
+    int rotation = 0;
+    int renderMode = 0;
+    GLfloat vertices[20];
+
+    bool matches(int frWidth, int frHeight, int tgWidth, int tgHeight, int rot, int mode) const
+    {
+        return frameWidth == frWidth && frameHeight == frHeight && targetWidth == tgWidth
+            && targetHeight == tgHeight && rotation == rot && renderMode == mode;
+    }
+};
 
 class VideoRendererOpenGL
 {
@@ -20,24 +56,56 @@ public:
     int renderFrame(const agora::media::base::VideoFrame& videoFrame);
     int width() const { return m_targetWidth; }
     int height() const { return m_targetHeight; }
-    void setFrameInfo(int rotation);
+    // rotation: clockwise degrees of VideoFrame::rotation
+    // mirrored: left and right swapped on screen, as a front camera preview
+    void setFrameInfo(int rotation, bool mirrored = false);
 	void setRenderMode(int mode);
+    // YUV matrix and range of the frames, see VideoColorInfo
+    void setColorInfo(const VideoColorInfo& color) { m_color = color; }
+    const VideoColorInfo& colorInfo() const { return m_color; }
+    void setRenderQuality(int quality) { m_quality = quality; }
+    int renderQuality() const { return m_quality; }
+    // filter used by the last frame, never RENDER_QUALITY_AUTO
+    int activeQuality() const { return m_activeQuality; }
+    static const char* qualityName(int quality);
+    // GPU time of renderFrame measured with timer queries, averaged.
+    // gpuTimeMs is -1 while nothing was measured or queries are unsupported.
+    void setGpuTimingEnabled(bool enabled) { m_gpuTiming = enabled; }
+    float gpuTimeMs() const { return m_gpuTimeMs; }
+    // Draws diagnostic text over the last rendered frame, must be called
+    // from paintGL after renderFrame.
+    void renderHud(QPaintDevice* device, const QString& text);
 private:
-    int prepare(int frameWidth, int frameHeight);
     int frameSizeChange(int width, int height);
     QOpenGLShaderProgram* createProgram();
-    int applyVertices();
+    void initializeBuffers();
+    const DrawPlan& drawPlan(int frameWidth, int frameHeight);
+    void bindVertexAttribs();
+    void bindState();
+    void updateTexTransform();
+    void updateColorTransform();
     void setupTextures(const agora::media::base::VideoFrame& frameToRender);
     void initializeTexture(int name, int id, int width, int height);
+    int selectQuality() const;
+    void applyQuality(int quality);
+    void generateMipmaps();
+    void beginGpuTimer();
+    void endGpuTimer();
     void updateTextures(const agora::media::base::VideoFrame& frameToRender);
     void glTexSubImage2D(GLsizei width, GLsizei height, int stride, const uint8_t* plane);
-    int ajustVertices();
-    int adjustCoordinates(int frWidth, int frHeight, int targetWidth, int targetHeight, int renderMode);
+    int ajustVertices(DrawPlan& plan);
+    int adjustCoordinates(DrawPlan& plan, int frWidth, int frHeight, int targetWidth, int targetHeight, int renderMode);
     static QOpenGLFunctions* renderer();
     void cleanup();
 private:
     QOpenGLShaderProgram *m_program;
-    GLfloat m_vertices[20];
+    int m_positionHandle;
+    int m_textureHandle;
+    QOpenGLBuffer m_vertexBuffer;
+    QOpenGLBuffer m_indexBuffer;
+    QOpenGLVertexArrayObject m_vao;
+    DrawPlan m_plan;
+    bool m_planValid;
     GLuint m_textureIds[3]; // Texture id of Y,U and V texture.
 
     int m_zOrder;
@@ -51,9 +119,24 @@ private:
     int m_textureHeight;
     int m_targetWidth;
     int m_targetHeight;
-    bool m_resetGlVert;
     int m_rotation;
     bool m_mirrored;
+    // values last sent to uTexTransform
+    int m_transformRotation;
+    bool m_transformMirrored;
+    VideoColorInfo m_color;
+    // value last sent to uYuvToRgb/uYuvOffset
+    VideoColorInfo m_uploadedColor;
+    bool m_colorUploaded;
+    int m_quality;
+    int m_activeQuality;
+
+    bool m_gpuTiming;
+    bool m_gpuTimerPending;
+    bool m_gpuTimerRunning;
+    bool m_gpuTimerSupported;
+    QOpenGLTimerQuery* m_gpuTimer;
+    float m_gpuTimeMs;
 };
 
 #endif // VIDEORENDERER_OPENGL_H